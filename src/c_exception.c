@@ -31,9 +31,26 @@
 // standard
 #include <assert.h>
 #include <attribute.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdatomic.h>
 #include <stddef.h>
 #include <stdio.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <wchar.h>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif /* HAVE_PTHREAD_H */
+#if CX_JMP_BACKEND == CX_JMP_BACKEND_UNWIND
+#include <unwind.h>
+#ifdef __SANITIZE_ADDRESS__
+#include <sanitizer/asan_interface.h>
+#endif /* __SANITIZE_ADDRESS__ */
+#endif /* CX_JMP_BACKEND == CX_JMP_BACKEND_UNWIND */
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -43,20 +60,112 @@
  */
 
 /**
- * Macro that expands into whatever the platform uses to specify that a
- * variable is thread-local.
+ * The exception ID used internally for a #cx_try block whose #cx_finally
+ * block is being executed because of #cx_escape().
  */
-#if   __STDC_VERSION__ >= 202311L
-# define CX_IMPL_THREAD_LOCAL     thread_local
-#elif __STDC_VERSION__ >= 201112L
-# define CX_IMPL_THREAD_LOCAL     _Thread_local
-#elif defined( _MSC_VER )
-# define CX_IMPL_THREAD_LOCAL     __declspec( thread )
-#elif defined( __GNUC__ )
-# define CX_IMPL_THREAD_LOCAL     __thread
-#else
-# error "Don't know how to declare thread-local variables on this platform."
-#endif
+#define CX_IMPL_XID_ESCAPE        INT_MIN
+
+#if CX_JMP_BACKEND == CX_JMP_BACKEND_UNWIND
+/**
+ * The `_Unwind_Exception_Class` of the stack unwinding done by #cx_throw:
+ * `"CX\0\0"` (vendor) followed by `"C\0\0\0"` (language).
+ */
+#define CX_IMPL_UNWIND_CLASS      0x4358000043000000ull
+#endif /* CX_JMP_BACKEND == CX_JMP_BACKEND_UNWIND */
+
+#if CX_CANCEL_FINALLY && defined(HAVE_PTHREAD_H)
+/**
+ * The exception ID used internally for a #cx_try block whose #cx_finally
+ * block is being executed because its thread is exiting, i.e., it's been
+ * cancelled via `pthread_cancel()` or called `pthread_exit()`.
+ */
+#define CX_IMPL_XID_EXIT          (INT_MIN + 1)
+
+// These are glibc's that its pthread_cleanup_push() uses when not compiled
+// with -fexceptions, hence <pthread.h> doesn't declare them when it is.
+extern void __pthread_register_cancel( __pthread_unwind_buf_t* )
+  __cleanup_fct_attribute;
+extern void __pthread_unregister_cancel( __pthread_unwind_buf_t* )
+  __cleanup_fct_attribute;
+_Noreturn
+extern void __pthread_unwind_next( __pthread_unwind_buf_t* )
+  __cleanup_fct_attribute;
+#endif /* CX_CANCEL_FINALLY && HAVE_PTHREAD_H */
+
+/**
+ * The number of \ref cx_exception_ptr objects allocated at a time.
+ */
+#define CX_IMPL_XPTR_CHUNK_SIZE   CX_CAUSE_MAX
+
+/**
+ * A per-thread pool of \ref cx_exception_ptr objects.
+ */
+struct cx_impl_xptr_pool {
+  /**
+   * Free list used only by the owning thread.
+   */
+  cx_exception_ptr_t           *free_list;
+
+  /**
+   * Free list of objects released by other threads: they push onto it; only
+   * the owning thread takes it (all at once), so there's no ABA problem.
+   */
+  _Atomic(cx_exception_ptr_t*)  remote_list;
+
+  /**
+   * The number of objects in use plus 1 for as long as the owning thread is
+   * alive.  When it reaches 0, the pool is freed.
+   */
+  atomic_uint                   live;
+
+  /**
+   * The chunks of objects allocated.
+   */
+  struct cx_impl_xptr_chunk    *chunks;
+};
+typedef struct cx_impl_xptr_pool cx_impl_xptr_pool_t;
+
+/**
+ * A reference-counted copy of a thrown exception.
+ */
+struct cx_exception_ptr {
+  cx_exception_t        cex;            ///< The exception.
+  atomic_uint           refs;           ///< Reference count.
+  cx_impl_xptr_pool_t  *pool;           ///< The pool it belongs to.
+  cx_exception_ptr_t   *next;           ///< Next in a free list, if any.
+};
+
+/**
+ * A chunk of \ref cx_exception_ptr objects.
+ */
+struct cx_impl_xptr_chunk {
+  struct cx_impl_xptr_chunk  *next;     ///< Next chunk, if any.
+  cx_exception_ptr_t          xptrs[ CX_IMPL_XPTR_CHUNK_SIZE ];
+};
+
+/**
+ * The kind of argument a `printf()` conversion consumes.
+ */
+enum cx_impl_conv_kind {
+  CX_IMPL_CONV_NONE,                    ///< None, e.g., `%%`.
+  CX_IMPL_CONV_SINT,                    ///< A signed integer.
+  CX_IMPL_CONV_UINT,                    ///< An unsigned integer.
+  CX_IMPL_CONV_CHAR,                    ///< A character.
+  CX_IMPL_CONV_DOUBLE,                  ///< A floating-point number.
+  CX_IMPL_CONV_PTR                      ///< A pointer.
+};
+typedef enum cx_impl_conv_kind cx_impl_conv_kind_t;
+
+/**
+ * A parsed `printf()` conversion specification.
+ */
+struct cx_impl_conv {
+  char const   *end;                    ///< One past the conversion character.
+  unsigned      n_stars;                ///< Number of `*` width/precision.
+  char          length;                 ///< Length modifier, if any.
+  char          conv;                   ///< Conversion character.
+};
+typedef struct cx_impl_conv cx_impl_conv_t;
 
 // local functions
 _Noreturn
@@ -66,25 +175,117 @@ _Noreturn
 static void cx_terminate( void );
 
 /**
- * Current exception.
+ * The exception IDs "caught" by every \ref cx_co_try: any.  Declaring them
+ * makes #cx_escape() skip coroutine "try" frames (that have no #cx_finally
+ * block) and identifies them as such.
+ */
+static int const cx_impl_co_try_xids[] = { 1, false, CX_XID_ANY };
+
+/**
+ * The current thread's own exception.
+ */
+static CX_IMPL_THREAD_LOCAL cx_exception_t cx_impl_thread_exception;
+
+/**
+ * The site of the #cx_noexcept, if any, that an exception escaped.
+ */
+static CX_IMPL_THREAD_LOCAL cx_site_t cx_impl_noexcept_site;
+
+/**
+ * The current exception or NULL for \ref cx_impl_thread_exception.  It's
+ * a pointer so cx_state_swap() needn't copy exceptions.
+ */
+static CX_IMPL_THREAD_LOCAL cx_exception_t *cx_impl_exception_;
+
+/**
+ * Buffer for the message returned by cx_exception_message().
  */
-static CX_IMPL_THREAD_LOCAL cx_exception_t cx_impl_exception;
+static CX_IMPL_THREAD_LOCAL char cx_impl_message_buf[ CX_MESSAGE_SIZE_MAX ];
+
+/**
+ * The #cx_escape_point being escaped to, if any.
+ */
+static CX_IMPL_THREAD_LOCAL cx_impl_try_block_t *cx_impl_escape_target;
+
+/**
+ * The value passed to the most recent #cx_escape().
+ */
+static CX_IMPL_THREAD_LOCAL void *cx_impl_escape_value_;
 
 /**
  * Current terminate handler.
  */
-static cx_terminate_handler_t cx_impl_terminate_handler =
+static _Atomic(cx_terminate_handler_t) cx_impl_terminate_handler =
   &cx_impl_default_terminate_handler;
 
 /**
- * Linked list of open "try" blocks.
+ * Current per-thread terminate handler, if any.
+ */
+static CX_IMPL_THREAD_LOCAL cx_terminate_handler_t
+  cx_impl_thread_terminate_handler;
+
+#if CX_JMP_BACKEND == CX_JMP_BACKEND_UNWIND
+/**
+ * The exception the stack is unwound with.  It can't be a local variable
+ * since the cleanups run while unwinding reuse the stack it would be on.
  */
-static CX_IMPL_THREAD_LOCAL cx_impl_try_block_t *cx_impl_try_block_head;
+static CX_IMPL_THREAD_LOCAL struct _Unwind_Exception cx_impl_unwind_exception;
+
+/**
+ * The #cx_try block the stack is being unwound to, if any.
+ */
+static CX_IMPL_THREAD_LOCAL cx_impl_try_block_t *cx_impl_unwind_target;
+#endif /* CX_JMP_BACKEND == CX_JMP_BACKEND_UNWIND */
+
+// extern variables
+CX_IMPL_THREAD_LOCAL cx_impl_try_block_t *cx_impl_try_block_head;
+CX_IMPL_THREAD_LOCAL cx_impl_context_scope_t *cx_impl_context_top;
+CX_IMPL_THREAD_LOCAL sig_atomic_t volatile cx_impl_busy;
+CX_IMPL_THREAD_LOCAL sig_atomic_t volatile cx_impl_busy_deferred_sig;
+
+#if defined(__GNUC__) && defined(__ELF__)
+//
+// Bounds of the "cx_sites" section generated by the linker.  They're weak
+// since they're undefined if there are no throw sites at all.  (No function
+// may be named cx_sites: the assembler would take a call to it as referring
+// to the section.)
+//
+extern cx_site_t const __start_cx_sites[] __attribute__((weak));
+extern cx_site_t const __stop_cx_sites[]  __attribute__((weak));
+#endif /* __GNUC__ && __ELF__ */
 
 /**
  * Current exception matcher function.
  */
-static cx_xid_matcher_t cx_xid_matcher = &cx_impl_default_xid_matcher;
+static _Atomic(cx_xid_matcher_t) cx_xid_matcher = &cx_impl_default_xid_matcher;
+
+/**
+ * Current per-thread exception matcher function, if any.
+ */
+static CX_IMPL_THREAD_LOCAL cx_xid_matcher_t cx_impl_thread_xid_matcher;
+
+/**
+ * Innermost #cx_try_with_matcher, if any.
+ */
+static CX_IMPL_THREAD_LOCAL cx_impl_matcher_scope_t *cx_impl_matcher_scope_top;
+
+/**
+ * This thread's pool of \ref cx_exception_ptr objects, if any.
+ */
+static CX_IMPL_THREAD_LOCAL cx_impl_xptr_pool_t *cx_impl_xptr_pool;
+
+#ifdef HAVE_PTHREAD_H
+/**
+ * Key used only to release a thread's \ref cx_impl_xptr_pool when the thread
+ * exits.
+ */
+static pthread_key_t  cx_impl_xptr_pool_key;
+
+/**
+ * Used to create \ref cx_impl_xptr_pool_key only once.
+ */
+static pthread_once_t cx_impl_xptr_pool_key_once = PTHREAD_ONCE_INIT;
+#endif /* HAVE_PTHREAD_H */
 
 ////////// local functions ////////////////////////////////////////////////////
 
@@ -106,6 +307,44 @@ static void cx_impl_assert_try_block( cx_impl_try_block_t const *tb ) {
   abort();
 }
 
+/**
+ * Begins a region in which this library's per-thread state is inconsistent,
+ * i.e., a signal handler must not throw.
+ *
+ * @sa cx_impl_busy_end()
+ */
+static inline void cx_impl_busy_begin( void ) {
+  cx_impl_busy = 1;
+  atomic_signal_fence( memory_order_seq_cst );
+}
+
+/**
+ * Ends a region begun by cx_impl_busy_begin(): if a signal handler deferred
+ * throwing during it, raises its signal again.
+ *
+ * @note It must be called before any `longjmp()` out of the region.
+ */
+static inline void cx_impl_busy_end( void ) {
+  atomic_signal_fence( memory_order_seq_cst );
+  cx_impl_busy = 0;
+  int const sig = cx_impl_busy_deferred_sig;
+  if ( sig != 0 ) {
+    cx_impl_busy_deferred_sig = 0;
+    raise( sig );
+  }
+}
+
+/**
+ * Gets the current exception.
+ *
+ * @return Returns a pointer to the current exception, whether or not one is
+ * in progress.
+ */
+static inline cx_exception_t* cx_impl_exception( void ) {
+  cx_exception_t *const cex = cx_impl_exception_;
+  return cex != NULL ? cex : &cx_impl_thread_exception;
+}
+
 /**
  * Default terminate handler.
  *
@@ -115,11 +354,15 @@ static void cx_impl_assert_try_block( cx_impl_try_block_t const *tb ) {
 _Noreturn
 static void cx_impl_default_terminate_handler( cx_exception_t const *cex ) {
   assert( cex != NULL );
+  char const *const msg = cx_exception_message( cex );
   fprintf( stderr,
-    "%s:%d: unhandled exception %d (0x%X)\n",
-    cex->thrown_file, cex->thrown_line,
-    cex->thrown_xid, (unsigned)cex->thrown_xid
+    "%s:%d: unhandled exception %d (0x%X)%s%s\n",
+    cx_exception_file( cex ), cx_exception_line( cex ),
+    cex->thrown_xid, (unsigned)cex->thrown_xid,
+    msg != NULL ? ": " : "", msg != NULL ? msg : ""
   );
+  for ( unsigned i = 0; i < cex->n_contexts; ++i )
+    fprintf( stderr, "  in context: %s\n", cx_exception_context( cex, i ) );
   abort();
 }
 
@@ -134,16 +377,803 @@ static bool cx_impl_default_xid_matcher( int thrown_xid, int catch_xid ) {
   return thrown_xid == catch_xid;
 }
 
+/**
+ * Checks whether the exception thrown to \a tb may be caught by a "catch"
+ * block of \a tb.
+ *
+ * @param tb A pointer to the \ref cx_impl_try_block to check.
+ * @return Returns `true` only if the exception may be caught.
+ */
+static bool cx_impl_catchable( cx_impl_try_block_t const *tb ) {
+  assert( tb != NULL );
+  assert( tb->state == CX_IMPL_THROWN );
+  //
+  // The thrown and caught exception IDs can be the same when the same
+  // exception is thrown from a "catch" block.  For example, given:
+  //
+  //      try {
+  //        try {
+  //          throw( XID_1 );         // 1
+  //        }
+  //        catch( XID_1 ) {          // 2
+  //          throw();                // 3
+  //        }
+  //        finally {                 // 4
+  //          // ...
+  //        }
+  //      }
+  //      catch( XID_1 ) {            // 5
+  //        // ...
+  //      }
+  //
+  // we want the flow to go from 1 to 5 in sequence. If this check were not
+  // here, we'd loop endlessly between 2-3.
+  //
+  // Once an exception is caught at the current try/catch nesting level, it
+  // can never be recaught at the same level.  By returning "false" for all
+  // catches at the current level, we execute the "finally" block, if any, of
+  // the current level; then the CX_IMPL_FINALLY state will pop us up to the
+  // parent level, if any, where this check will succeed (because the parent's
+  // caught_xid will be 0) and we can possibly recatch the exception at the
+  // parent level.
+  //
+  return tb->caught_xid != tb->thrown_xid;
+}
+
+/**
+ * Marks the exception thrown to \a tb as caught.
+ *
+ * @param tb A pointer to the \ref cx_impl_try_block that caught it.
+ * @return Always returns `true`.
+ */
+static bool cx_impl_caught( cx_impl_try_block_t *tb ) {
+  tb->state = CX_IMPL_CAUGHT;
+  tb->caught_xid = tb->thrown_xid;
+  return true;
+}
+
+/**
+ * Gets the exception matcher function currently in effect for this thread:
+ * that of the innermost #cx_try_with_matcher, if any; else the per-thread
+ * one, if any; else the global one.
+ *
+ * @remarks The global one is loaded using relaxed memory order: calling the
+ * function doesn't depend on any other memory written by whichever thread set
+ * it, so no fence is needed.
+ *
+ * @return Returns said function.
+ */
+static inline cx_xid_matcher_t cx_impl_xid_matcher( void ) {
+  if ( cx_impl_matcher_scope_top != NULL ) {
+    return cx_impl_matcher_scope_top->matcher != NULL ?
+      cx_impl_matcher_scope_top->matcher : &cx_impl_default_xid_matcher;
+  }
+  if ( cx_impl_thread_xid_matcher != NULL )
+    return cx_impl_thread_xid_matcher;
+  return atomic_load_explicit( &cx_xid_matcher, memory_order_relaxed );
+}
+
+/**
+ * Pops \a ms from the stack of #cx_try_with_matcher blocks, if it's the
+ * innermost.
+ *
+ * @param ms A pointer to the \ref cx_impl_matcher_scope to pop.
+ */
+static void cx_impl_matcher_scope_pop_top( cx_impl_matcher_scope_t const *ms ) {
+  if ( cx_impl_matcher_scope_top == ms )
+    cx_impl_matcher_scope_top = ms->prev;
+}
+
+/**
+ * Checks whether \a thrown_xid matches \a catch_xid using either
+ * #CX_XID_MATCHER, if defined, or the current \ref cx_xid_matcher_t.
+ *
+ * @param thrown_xid The thrown exception ID.
+ * @param catch_xid The exception ID to match \a thrown_xid against.
+ * @return Returns `true` only if \a thrown_xid matches \a catch_xid.
+ */
+static inline bool cx_impl_match( int thrown_xid, int catch_xid ) {
+#ifdef CX_XID_MATCHER
+  return CX_XID_MATCHER( thrown_xid, catch_xid );
+#else
+  return (*cx_impl_xid_matcher())( thrown_xid, catch_xid );
+#endif /* CX_XID_MATCHER */
+}
+
+/**
+ * Gets the kind of argument consumed by a `printf()` conversion.
+ *
+ * @param conv The conversion character.
+ * @return Returns said kind.
+ */
+static cx_impl_conv_kind_t cx_impl_conv_kind( char conv ) {
+  switch ( conv ) {
+    case 'd':
+    case 'i':
+      return CX_IMPL_CONV_SINT;
+    case 'o':
+    case 'u':
+    case 'x':
+    case 'X':
+      return CX_IMPL_CONV_UINT;
+    case 'c':
+      return CX_IMPL_CONV_CHAR;
+    case 'a':
+    case 'A':
+    case 'e':
+    case 'E':
+    case 'f':
+    case 'F':
+    case 'g':
+    case 'G':
+      return CX_IMPL_CONV_DOUBLE;
+    case 'n':
+    case 'p':
+    case 's':
+      return CX_IMPL_CONV_PTR;
+    default:
+      return CX_IMPL_CONV_NONE;
+  } // switch
+}
+
+/**
+ * Parses a `printf()` conversion specification.
+ *
+ * @param format A pointer to the `%` beginning the specification.
+ * @param conv The \ref cx_impl_conv to parse into.  For length modifiers,
+ * `hh` and `ll` are set as `H` and `q`, respectively.
+ */
+static void cx_impl_conv_parse( char const *format, cx_impl_conv_t *conv ) {
+  assert( format != NULL );
+  assert( *format == '%' );
+  assert( conv != NULL );
+
+  static char const DIGITS[] = "0123456789";
+  char const *f = format + 1;
+  conv->n_stars = 0;
+
+  f += strspn( f, "-+ #0'" );
+  if ( *f == '*' )
+    ++conv->n_stars, ++f;
+  else
+    f += strspn( f, DIGITS );
+  if ( *f == '.' ) {
+    if ( *++f == '*' )
+      ++conv->n_stars, ++f;
+    else
+      f += strspn( f, DIGITS );
+  }
+
+  conv->length = '\0';
+  switch ( *f ) {
+    case 'h':
+      if ( *++f == 'h' )
+        conv->length = 'H', ++f;
+      else
+        conv->length = 'h';
+      break;
+    case 'l':
+      if ( *++f == 'l' )
+        conv->length = 'q', ++f;
+      else
+        conv->length = 'l';
+      break;
+    case 'j':
+    case 'L':
+    case 't':
+    case 'z':
+      conv->length = *f++;
+      break;
+  } // switch
+
+  conv->conv = *f;
+  conv->end = *f == '\0' ? f : f + 1;
+}
+
+/**
+ * Formats a single `printf()` conversion.
+ *
+ * @param buf The buffer to format into.
+ * @param size The size of \a buf.
+ * @param spec The conversion specification with any `*` already replaced.
+ * @param conv The parsed \a spec.
+ * @param arg The argument, if any.
+ * @return Returns the number of characters that would have been formatted
+ * given enough space.
+ */
+static int cx_impl_conv_format( char *buf, size_t size, char const *spec,
+                                cx_impl_conv_t const *conv,
+                                union cx_impl_format_arg const *arg ) {
+#if defined(__GNUC__)
+# pragma GCC diagnostic push
+# pragma GCC diagnostic ignored "-Wformat-nonliteral"
+#endif /* __GNUC__ */
+  switch ( cx_impl_conv_kind( conv->conv ) ) {
+    case CX_IMPL_CONV_SINT:
+      switch ( conv->length ) {
+        case 'l': return snprintf( buf, size, spec, (long)arg->i );
+        case 'q': return snprintf( buf, size, spec, arg->i );
+        case 'j': return snprintf( buf, size, spec, (intmax_t)arg->i );
+        case 't': return snprintf( buf, size, spec, (ptrdiff_t)arg->i );
+        case 'z': return snprintf( buf, size, spec, (ssize_t)arg->i );
+        default : return snprintf( buf, size, spec, (int)arg->i );
+      } // switch
+    case CX_IMPL_CONV_UINT:
+      switch ( conv->length ) {
+        case 'l': return snprintf( buf, size, spec, (unsigned long)arg->i );
+        case 'q': return snprintf( buf, size, spec, (unsigned long long)arg->i );
+        case 'j': return snprintf( buf, size, spec, (uintmax_t)arg->i );
+        case 't': return snprintf( buf, size, spec, (size_t)arg->i );
+        case 'z': return snprintf( buf, size, spec, (size_t)arg->i );
+        default : return snprintf( buf, size, spec, (unsigned)arg->i );
+      } // switch
+    case CX_IMPL_CONV_CHAR:
+      if ( conv->length == 'l' )
+        return snprintf( buf, size, spec, (wint_t)arg->i );
+      return snprintf( buf, size, spec, (int)arg->i );
+    case CX_IMPL_CONV_DOUBLE:
+      if ( conv->length == 'L' )
+        return snprintf( buf, size, spec, (long double)arg->d );
+      return snprintf( buf, size, spec, arg->d );
+    case CX_IMPL_CONV_PTR:
+      if ( conv->conv == 'n' )
+        return 0;
+      return snprintf( buf, size, spec, arg->p );
+    case CX_IMPL_CONV_NONE:
+      return snprintf( buf, size, "%s", conv->conv == '%' ? "%" : "" );
+  } // switch
+  unreachable();
+#if defined(__GNUC__)
+# pragma GCC diagnostic pop
+#endif /* __GNUC__ */
+}
+
+/**
+ * Formats \a format and its arguments into \ref cx_impl_message_buf.
+ *
+ * @param format The `printf()` format.
+ * @param args The arguments recorded for \a format.
+ * @param n_args The number of elements of \a args.
+ * @return Returns \ref cx_impl_message_buf.
+ */
+static char const* cx_impl_format( char const *format,
+                                   union cx_impl_format_arg const args[],
+                                   unsigned n_args ) {
+  assert( format != NULL );
+
+  char *const buf = cx_impl_message_buf;
+  size_t const size = sizeof cx_impl_message_buf;
+  union cx_impl_format_arg const *arg = args;
+  union cx_impl_format_arg const *const end = args + n_args;
+  size_t len = 0;
+
+  for ( char const *f = format; len < size - 1; ) {
+    char const *const pct = strchr( f, '%' );
+    size_t const lit_len = pct != NULL ? (size_t)(pct - f) : strlen( f );
+    size_t const n = lit_len < size - 1 - len ? lit_len : size - 1 - len;
+    memcpy( buf + len, f, n );
+    len += n;
+    if ( pct == NULL || len == size - 1 )
+      break;
+
+    cx_impl_conv_t conv;
+    cx_impl_conv_parse( pct, &conv );
+    f = conv.end;
+
+    //
+    // Copy the conversion specification replacing each `*` by the value of
+    // its argument.
+    //
+    char spec[ 64 ];
+    size_t spec_len = 0;
+    for ( char const *s = pct; s < conv.end; ++s ) {
+      if ( spec_len + sizeof "-2147483648" >= sizeof spec )
+        goto done;                      // absurdly long specification
+      if ( *s != '*' ) {
+        spec[ spec_len++ ] = *s;
+        continue;
+      }
+      if ( arg == end )
+        goto done;
+      int const star = (int)(arg++)->i;
+      if ( star < 0 && spec[ spec_len - 1 ] == '.' )
+        --spec_len;                     // negative precision: as if omitted
+      else
+        spec_len += (size_t)sprintf( spec + spec_len, "%d", star );
+    } // for
+    spec[ spec_len ] = '\0';
+
+    bool const has_arg = cx_impl_conv_kind( conv.conv ) != CX_IMPL_CONV_NONE;
+    if ( has_arg && arg == end )
+      break;
+    int const rv =
+      cx_impl_conv_format( buf + len, size - len, spec, &conv, arg );
+    if ( rv > 0 )
+      len += (size_t)rv < size - 1 - len ? (size_t)rv : size - 1 - len;
+    if ( has_arg )
+      ++arg;
+  } // for
+
+done:
+  buf[ len ] = '\0';
+  return buf;
+}
+
+/**
+ * Gets the value of the integer of \a size bytes pointed to by \a value.
+ *
+ * @param kind Either #CX_IMPL_PAYLOAD_SINT or #CX_IMPL_PAYLOAD_UINT.
+ * @param value A pointer to the integer.
+ * @param size The size in bytes of the integer.
+ * @return Returns said value.
+ */
+static long long cx_impl_payload_int( cx_impl_payload_kind_t kind,
+                                      void const *value, size_t size ) {
+  bool const is_signed = kind == CX_IMPL_PAYLOAD_SINT;
+  switch ( size ) {
+    case 1: {
+      uint8_t u;
+      memcpy( &u, value, sizeof u );
+      return is_signed ? (long long)(int8_t)u : (long long)u;
+    }
+    case 2: {
+      uint16_t u;
+      memcpy( &u, value, sizeof u );
+      return is_signed ? (long long)(int16_t)u : (long long)u;
+    }
+    case 4: {
+      uint32_t u;
+      memcpy( &u, value, sizeof u );
+      return is_signed ? (long long)(int32_t)u : (long long)u;
+    }
+    default: {
+      assert( size == 8 );
+      int64_t i;
+      memcpy( &i, value, sizeof i );
+      return i;
+    }
+  } // switch
+}
+
+/**
+ * Checks whether exception \a xid matches any of \a xids.
+ *
+ * @param xids The exception IDs to match against.  If any is #CX_XID_ANY, it
+ * always matches.
+ * @param n_xids The number of exception IDs.
+ * @param xid The thrown exception ID.
+ * @return Returns `true` only if \a xid matches any of \a xids.
+ */
+static bool cx_impl_xids_match( int const xids[], unsigned n_xids, int xid ) {
+  assert( xids != NULL || n_xids == 0 );
+#ifndef CX_XID_MATCHER
+  if ( cx_impl_xid_matcher() == &cx_impl_default_xid_matcher ) {
+    //
+    // For the default matcher, don't stop at the first match: a loop without
+    // an early exit can be vectorized into a few comparisons.
+    //
+    bool matched = false;
+    for ( unsigned i = 0; i < n_xids; ++i )
+      matched |= xids[i] == xid || xids[i] == CX_XID_ANY;
+    return matched;
+  }
+#endif /* CX_XID_MATCHER */
+  for ( unsigned i = 0; i < n_xids; ++i ) {
+    if ( xids[i] == CX_XID_ANY || cx_impl_match( xid, xids[i] ) )
+      return true;
+  } // for
+  return false;
+}
+
+/**
+ * Checks whether \a tb may have a #cx_finally block.
+ *
+ * @param tb A pointer to the \ref cx_impl_try_block to check.
+ * @return Returns `false` only if \a tb was declared by #cx_try_catching (or
+ * is a coroutine "try" frame) as having no #cx_finally block.
+ */
+static inline bool cx_impl_try_block_has_finally(
+  cx_impl_try_block_t const *tb
+) {
+  return tb->catch_xids == NULL || tb->catch_xids[1] != 0;
+}
+
+/**
+ * Checks whether \a tb could possibly handle exception \a xid, i.e., whether
+ * control must be transferred to it.
+ *
+ * @param tb A pointer to the \ref cx_impl_try_block to check.
+ * @param xid The thrown exception ID.
+ * @return Returns `true` only if \a tb could handle \a xid; `false` only if
+ * \a tb can be skipped.
+ */
+static bool cx_impl_try_block_handles( cx_impl_try_block_t const *tb,
+                                       int xid ) {
+  assert( tb != NULL );
+  switch ( tb->state ) {
+    case CX_IMPL_CONTEXT:
+    case CX_IMPL_ESCAPE:
+    case CX_IMPL_SCOPE:
+      return false;
+    case CX_IMPL_FINALLY:
+      //
+      // The exception was thrown from its "finally" block: it's done with,
+      // so the exception propagates to its parent.
+      //
+      return false;
+    default:
+      break;
+  } // switch
+  if ( tb->state != CX_IMPL_TRY || cx_impl_try_block_has_finally( tb ) ) {
+    //
+    // Either the try block is already in a "catch" block, it didn't declare
+    // what it catches, or it has a "finally" block that must be run: we have
+    // to transfer control to it.
+    //
+    return true;
+  }
+  return cx_impl_xids_match(
+    tb->catch_xids + 2, (unsigned)tb->catch_xids[0], xid
+  );
+}
+
+#if CX_JMP_BACKEND == CX_JMP_BACKEND_UNWIND
+/**
+ * Called by the unwinder for every frame being unwound before running its
+ * cleanups, if any.  Normally, the cleanup of \ref cx_impl_unwind_target
+ * itself resumes it (see cx_impl_try_unwound()); but if its function either
+ * wasn't compiled with `-fexceptions` or was interrupted by a signal, it has
+ * none, so this records the frame pointer and stack pointer of every frame and
+ * resumes it directly with those of its frame once unwinding has passed it.
+ *
+ * @param version The unwinder's version.
+ * @param actions The `_UA_*` actions.
+ * @param exc_class The exception class.
+ * @param exc A pointer to the exception.
+ * @param context A pointer to the context of the frame being unwound.
+ * @param param Not used.
+ * @return Returns `_URC_NO_REASON` to continue unwinding.
+ */
+static _Unwind_Reason_Code
+cx_impl_unwind_stop( int version, _Unwind_Action actions,
+                     _Unwind_Exception_Class exc_class,
+                     struct _Unwind_Exception *exc,
+                     struct _Unwind_Context *context, void *param ) {
+  (void)version;
+  (void)exc_class;
+  (void)exc;
+  (void)param;
+  cx_impl_try_block_t *const tb = cx_impl_unwind_target;
+  assert( tb != NULL );
+
+  // The canonical frame address of the frame called by the one being unwound
+  // is the latter's stack pointer.
+  uintptr_t const sp = _Unwind_GetCFA( context );
+  if ( sp > (uintptr_t)tb ) {
+    // The frame unwound just before this one was tb's.
+    cx_impl_unwind_target = NULL;
+    cx_impl_busy_end();
+    cx_impl_ctx_restore( tb->env );
+  }
+  if ( (actions & _UA_END_OF_STACK) != 0 ) {
+    fprintf( stderr,
+      "%s:%d: \"try\" not found on stack while unwinding\n",
+      tb->try_file, tb->try_line
+    );
+    abort();
+  }
+  tb->env->rbp = (void*)_Unwind_GetGR( context, 6 /* %rbp */ );
+  tb->env->rsp = (void*)sp;
+  return _URC_NO_REASON;
+}
+
+/**
+ * Unwinds the stack to the function containing \a tb whose cleanup then
+ * resumes it (see cx_impl_try_unwound()).
+ *
+ * @param tb A pointer to the \ref cx_impl_try_block to unwind to.
+ *
+ * @note The thread remains busy (see cx_impl_busy_begin()) until \a tb is
+ * resumed.
+ */
+_Noreturn
+static void cx_impl_unwind( cx_impl_try_block_t *tb ) {
+  if ( cx_impl_unwind_target != NULL ) {
+    fprintf( stderr,
+      "%s:%d: exception thrown by cleanup while unwinding to \"try\"\n",
+      cx_impl_unwind_target->try_file, cx_impl_unwind_target->try_line
+    );
+    abort();
+  }
+  cx_impl_unwind_target = tb;
+#ifdef __SANITIZE_ADDRESS__
+  // As C++'s throw does, unpoison the stack frames that will be jumped over.
+  __asan_handle_no_return();
+#endif /* __SANITIZE_ADDRESS__ */
+  cx_impl_unwind_exception = (struct _Unwind_Exception){
+    .exception_class = CX_IMPL_UNWIND_CLASS
+  };
+  _Unwind_ForcedUnwind( &cx_impl_unwind_exception, &cx_impl_unwind_stop, NULL );
+  abort();                              // returns only on error
+}
+#endif /* CX_JMP_BACKEND == CX_JMP_BACKEND_UNWIND */
+
+/**
+ * Transfers control to \a tb, i.e., makes its #CX_IMPL_SETJMP() return again.
+ *
+ * @param tb A pointer to the \ref cx_impl_try_block to transfer control to.
+ *
+ * @note It must be called only while busy (see cx_impl_busy_begin()).
+ */
+_Noreturn
+static void cx_impl_jump( cx_impl_try_block_t *tb ) {
+#if CX_JMP_BACKEND == CX_JMP_BACKEND_UNWIND
+  // A coroutine's "try" frame saved its full execution context instead.
+  if ( tb->catch_xids != cx_impl_co_try_xids )
+    cx_impl_unwind( tb );
+#endif /* CX_JMP_BACKEND == CX_JMP_BACKEND_UNWIND */
+  cx_impl_busy_end();
+  CX_IMPL_LONGJMP( tb->env );
+}
+
+/**
+ * Continues escaping to \ref cx_impl_escape_target: transfers control either
+ * to the innermost #cx_try block in between whose #cx_finally block, if any,
+ * has yet to be executed, or to the #cx_escape_point itself.
+ */
+_Noreturn
+static void cx_impl_do_escape( void ) {
+  cx_impl_try_block_t *const eb = cx_impl_escape_target;
+  assert( eb != NULL );
+  cx_impl_try_block_t *tb = cx_impl_try_block_head;
+  for ( ; tb != eb; tb = tb->parent ) {
+    assert( tb != NULL );
+    if ( tb->state == CX_IMPL_SCOPE )
+      cx_impl_matcher_scope_pop_top( (cx_impl_matcher_scope_t*)tb );
+    if ( (tb->state == CX_IMPL_TRY || tb->state == CX_IMPL_THROWN ||
+          tb->state == CX_IMPL_CAUGHT) &&
+         cx_impl_try_block_has_finally( tb ) ) {
+      //
+      // Making the thrown and caught exception IDs the same makes all
+      // cx_catch blocks not match (see cx_impl_catchable()) so control goes
+      // directly to its cx_finally block, if any.
+      //
+      tb->state = CX_IMPL_THROWN;
+      tb->thrown_xid = tb->caught_xid = CX_IMPL_XID_ESCAPE;
+      break;
+    }
+  } // for
+  cx_impl_try_block_head = tb;
+  if ( tb == eb )
+    cx_impl_escape_target = NULL;
+  cx_impl_jump( tb );
+}
+
 /**
  * Actually "throws" the current exception.
+ *
+ * @remarks This is done in two phases: first, search for the first try block
+ * that could handle the exception, skipping (and popping) any that can't;
+ * second, transfer control to it.
  */
 _Noreturn
 static void cx_impl_do_throw( void ) {
-  if ( cx_impl_try_block_head == NULL )
+  cx_exception_t *const cex = cx_impl_exception();
+  cx_impl_try_block_t *tb = cx_impl_try_block_head;
+  while ( tb != NULL && !cx_impl_try_block_handles( tb, cex->thrown_xid ) ) {
+    if ( tb->state == CX_IMPL_SCOPE )
+      cx_impl_matcher_scope_pop_top( (cx_impl_matcher_scope_t*)tb );
+    tb = tb->parent;
+  } // while
+  cx_impl_try_block_head = tb;
+  if ( tb == NULL )
+    cx_terminate();
+  if ( tb->state == CX_IMPL_NOEXCEPT ) {
+    cx_impl_noexcept_site =
+      (cx_site_t){ .file = tb->try_file, .line = tb->try_line };
+    cex->thrown_site = &cx_impl_noexcept_site;
     cx_terminate();
-  cx_impl_try_block_head->state = CX_IMPL_THROWN;
-  cx_impl_try_block_head->thrown_xid = cx_impl_exception.thrown_xid;
-  longjmp( cx_impl_try_block_head->env, 1 );
+  }
+  tb->state = CX_IMPL_THROWN;
+  tb->thrown_xid = cex->thrown_xid;
+  cx_impl_jump( tb );
+}
+
+/**
+ * Releases a reference to \a pool: if it was the last reference, frees it.
+ *
+ * @param pool A pointer to the \ref cx_impl_xptr_pool to release.
+ */
+static void cx_impl_xptr_pool_release( cx_impl_xptr_pool_t *pool ) {
+  assert( pool != NULL );
+  if ( atomic_fetch_sub_explicit( &pool->live, 1, memory_order_acq_rel ) != 1 )
+    return;
+  for ( struct cx_impl_xptr_chunk *chunk = pool->chunks, *next;
+        chunk != NULL; chunk = next ) {
+    next = chunk->next;
+    free( chunk );
+  } // for
+  free( pool );
+}
+
+#ifdef HAVE_PTHREAD_H
+/**
+ * Called when a thread that has a \ref cx_impl_xptr_pool exits.
+ *
+ * @param pool A pointer to the thread's \ref cx_impl_xptr_pool.
+ */
+static void cx_impl_xptr_pool_thread_exit( void *pool ) {
+  cx_impl_xptr_pool_release( pool );
+}
+
+/**
+ * Creates \ref cx_impl_xptr_pool_key.
+ */
+static void cx_impl_xptr_pool_key_init( void ) {
+  if ( pthread_key_create( &cx_impl_xptr_pool_key,
+                           &cx_impl_xptr_pool_thread_exit ) != 0 ) {
+    perror( "pthread_key_create()" );
+    abort();
+  }
+}
+#endif /* HAVE_PTHREAD_H */
+
+/**
+ * Allocates a new \ref cx_exception_ptr from this thread's pool.
+ *
+ * @param grow If `true` and the pool is empty, allocates another chunk of
+ * objects; if `false`, allocates a chunk only if the pool has none yet.
+ * @return Returns said object with its \ref cx_exception_ptr::cex "cex" and
+ * \ref cx_exception_ptr::refs "refs" uninitialized or NULL only if \a grow
+ * is `false` and the pool is empty.
+ */
+static cx_exception_ptr_t* cx_impl_xptr_alloc( bool grow ) {
+  cx_impl_xptr_pool_t *pool = cx_impl_xptr_pool;
+  if ( pool == NULL ) {
+    pool = malloc( sizeof *pool );
+    if ( pool == NULL ) {
+      perror( "malloc()" );
+      abort();
+    }
+    pool->free_list = NULL;
+    atomic_init( &pool->remote_list, NULL );
+    atomic_init( &pool->live, 1 );
+    pool->chunks = NULL;
+#ifdef HAVE_PTHREAD_H
+    pthread_once( &cx_impl_xptr_pool_key_once, &cx_impl_xptr_pool_key_init );
+    pthread_setspecific( cx_impl_xptr_pool_key, pool );
+#endif /* HAVE_PTHREAD_H */
+    cx_impl_xptr_pool = pool;
+  }
+
+  if ( pool->free_list == NULL ) {
+    pool->free_list = atomic_exchange_explicit(
+      &pool->remote_list, NULL, memory_order_acquire
+    );
+    if ( pool->free_list == NULL ) {
+      if ( !grow && pool->chunks != NULL )
+        return NULL;
+      struct cx_impl_xptr_chunk *const chunk = malloc( sizeof *chunk );
+      if ( chunk == NULL ) {
+        perror( "malloc()" );
+        abort();
+      }
+      chunk->next = pool->chunks;
+      pool->chunks = chunk;
+      for ( unsigned i = 0; i < CX_IMPL_XPTR_CHUNK_SIZE; ++i ) {
+        chunk->xptrs[i].pool = pool;
+        chunk->xptrs[i].next = i + 1 < CX_IMPL_XPTR_CHUNK_SIZE ?
+          &chunk->xptrs[ i + 1 ] : NULL;
+      } // for
+      pool->free_list = &chunk->xptrs[0];
+    }
+  }
+
+  cx_exception_ptr_t *const xp = pool->free_list;
+  pool->free_list = xp->next;
+  atomic_fetch_add_explicit( &pool->live, 1, memory_order_relaxed );
+  return xp;
+}
+
+/**
+ * Gets the \ref cx_exception_ptr containing \a cex.
+ *
+ * @param cex A pointer to the \ref cx_exception_ptr::cex "cex" of a \ref
+ * cx_exception_ptr.
+ * @return Returns said \ref cx_exception_ptr.
+ */
+static inline cx_exception_ptr_t* cx_impl_xptr_of( cx_exception_t const *cex ) {
+  return (cx_exception_ptr_t*)((char*)cex - offsetof( cx_exception_ptr_t, cex ));
+}
+
+/**
+ * Adds a reference to the cause, if any, of an exception.
+ *
+ * @param cause The \ref cx_exception::cause "cause" or NULL.
+ */
+static void cx_impl_cause_add_ref( cx_exception_t const *cause ) {
+  if ( cause != NULL )
+    cx_exception_ptr_copy( cx_impl_xptr_of( cause ) );
+}
+
+/**
+ * Allocates a \ref cx_exception_ptr to hold the cause of a nested exception.
+ *
+ * @remarks To keep a chained throw from allocating memory, the pool isn't
+ * grown.  If it's empty, a cause of the current exception is recycled
+ * instead, i.e., the cause chain is truncated: the oldest one other than the
+ * root cause since the latter is usually the most informative, unless it's
+ * the only one.
+ *
+ * @return Returns said object with its \ref cx_exception_ptr::cex "cex" and
+ * \ref cx_exception_ptr::refs "refs" uninitialized or NULL if none is
+ * available.
+ */
+static cx_exception_ptr_t* cx_impl_cause_alloc( void ) {
+  cx_exception_ptr_t *const xp = cx_impl_xptr_alloc( /*grow=*/false );
+  if ( xp != NULL )
+    return xp;
+  for ( cx_exception_t *cex = cx_impl_exception(); cex->cause != NULL; ) {
+    cx_exception_ptr_t *const cause_xp = cx_impl_xptr_of( cex->cause );
+    if ( atomic_load_explicit( &cause_xp->refs, memory_order_acquire ) != 1 )
+      break;                            // also referenced elsewhere
+    cx_exception_t const *const next = cause_xp->cex.cause;
+    if ( next == NULL || next->cause == NULL ) {
+      cex->cause = next;                // takes over its reference, if any
+      return cause_xp;
+    }
+    cex = &cause_xp->cex;
+  } // for
+  return NULL;
+}
+
+/**
+ * Releases a reference to the cause, if any, of an exception.
+ *
+ * @param cause The \ref cx_exception::cause "cause" or NULL.
+ */
+static void cx_impl_cause_release( cx_exception_t const *cause ) {
+  if ( cause != NULL )
+    cx_exception_ptr_release( cx_impl_xptr_of( cause ) );
+}
+
+/**
+ * Records the innermost #CX_CONTEXT_MAX #cx_context scopes, if any, in the
+ * current exception.
+ *
+ * @remarks If there are no #cx_context scopes, the list of open "try" blocks
+ * isn't walked at all.  Otherwise, the walk also corrects \ref
+ * cx_impl_context_top in case a previous throw left it stale.
+ */
+static void cx_impl_context_snapshot( void ) {
+  cx_exception_t *const cex = cx_impl_exception();
+  unsigned n = 0;
+  if ( cx_impl_context_top != NULL ) {
+    cx_impl_context_scope_t *top = NULL;
+    for ( cx_impl_try_block_t *tb = cx_impl_try_block_head; tb != NULL;
+          tb = tb->parent ) {
+      if ( tb->state != CX_IMPL_CONTEXT )
+        continue;
+      cx_impl_context_scope_t *const cs = (cx_impl_context_scope_t*)tb;
+      if ( top == NULL )
+        top = cs;
+      cex->contexts[ n++ ] = cs->context;
+      if ( n == CX_CONTEXT_MAX )
+        break;
+    } // for
+    cx_impl_context_top = top;
+  }
+  cex->n_contexts = n;
+}
+
+/**
+ * Clears the current exception.
+ */
+static void cx_impl_exception_clear( void ) {
+  cx_exception_t *const cex = cx_impl_exception();
+  cx_impl_cause_release( cex->cause );
+  // The contexts are meaningless once n_contexts is 0: don't clear them.
+  memset( cex, 0, offsetof( cx_exception_t, contexts ) );
 }
 
 /**
@@ -154,8 +1184,12 @@ static void cx_impl_do_throw( void ) {
  */
 _Noreturn
 static void cx_terminate( void ) {
-  assert( cx_impl_terminate_handler != NULL );
-  (*cx_impl_terminate_handler)( &cx_impl_exception );
+  cx_impl_busy_end();
+  cx_terminate_handler_t fn = cx_impl_thread_terminate_handler;
+  if ( fn == NULL )
+    fn = atomic_load_explicit( &cx_impl_terminate_handler, memory_order_acquire );
+  assert( fn != NULL );
+  (*fn)( cx_impl_exception() );
   unreachable();
 }
 
@@ -163,77 +1197,441 @@ static void cx_terminate( void ) {
 
 ////////// extern implementation functions ////////////////////////////////////
 
+#if CX_JMP_BACKEND == CX_JMP_BACKEND_X86_64 || \
+    CX_JMP_BACKEND == CX_JMP_BACKEND_UNWIND
+//
+// The callee-saved registers other than %rbp are deliberately not saved: the
+// CX_IMPL_SETJMP() macro clobbers them so the calling function saves and
+// restores them itself; and since cx_impl_ctx_save() is "returns_twice," no
+// values are kept in any register across the call.
+//
+__asm__(
+  "  .text\n"
+  "  .globl  cx_impl_ctx_save\n"
+  "  .type   cx_impl_ctx_save, @function\n"
+  "cx_impl_ctx_save:\n"
+  "  movq    %rbp, 0(%rdi)\n"
+  "  leaq    8(%rsp), %rax\n"             // %rsp after returning
+  "  movq    %rax, 8(%rdi)\n"
+  "  movq    (%rsp), %rax\n"              // return address
+  "  movq    %rax, 16(%rdi)\n"
+  "  xorl    %eax, %eax\n"
+  "  ret\n"
+  "  .size   cx_impl_ctx_save, .-cx_impl_ctx_save\n"
+  "\n"
+  "  .globl  cx_impl_ctx_restore\n"
+  "  .type   cx_impl_ctx_restore, @function\n"
+  "cx_impl_ctx_restore:\n"
+  "  movl    $1, %eax\n"
+  "  movq    0(%rdi), %rbp\n"
+  "  movq    8(%rdi), %rsp\n"
+  "  jmpq    *16(%rdi)\n"
+  "  .size   cx_impl_ctx_restore, .-cx_impl_ctx_restore\n"
+);
+#endif /* CX_JMP_BACKEND_X86_64 || CX_JMP_BACKEND_UNWIND */
+
+#if CX_JMP_BACKEND == CX_JMP_BACKEND_UNWIND
+//
+// When cx_impl_ctx_land() is called from a cleanup the unwinder is running,
+// %rbp and, once its own return address is popped, %rsp are those of the
+// function that called cx_impl_ctx_mark().
+//
+__asm__(
+  "  .text\n"
+  "  .globl  cx_impl_ctx_mark\n"
+  "  .type   cx_impl_ctx_mark, @function\n"
+  "cx_impl_ctx_mark:\n"
+  "  movq    (%rsp), %rax\n"              // return address
+  "  movq    %rax, 16(%rdi)\n"
+  "  xorl    %eax, %eax\n"
+  "  ret\n"
+  "  .size   cx_impl_ctx_mark, .-cx_impl_ctx_mark\n"
+  "\n"
+  "  .globl  cx_impl_ctx_land\n"
+  "  .type   cx_impl_ctx_land, @function\n"
+  "cx_impl_ctx_land:\n"
+  "  leaq    8(%rsp), %rsp\n"             // pop return address
+  "  movl    $1, %eax\n"
+  "  jmpq    *16(%rdi)\n"
+  "  .size   cx_impl_ctx_land, .-cx_impl_ctx_land\n"
+);
+#endif /* CX_JMP_BACKEND == CX_JMP_BACKEND_UNWIND */
+
 /// @cond DOXYGEN_IGNORE
 
 void cx_impl_cancel_try( cx_impl_try_block_t const *tb ) {
   cx_impl_assert_try_block( tb );
   cx_impl_try_block_head = tb->parent;
+  if ( tb->parent != NULL && tb->parent->state == CX_IMPL_SCOPE ) {
+    // The try block of a cx_try_with_matcher: cancel its scope also.
+    cx_impl_matcher_scope_pop( (cx_impl_matcher_scope_t*)tb->parent );
+  }
 }
 
 bool cx_impl_catch( int catch_xid, cx_impl_try_block_t *tb ) {
-  assert( tb != NULL );
-  assert( tb->state == CX_IMPL_THROWN );
+  if ( !cx_impl_catchable( tb ) )
+    return false;
+  if ( catch_xid != CX_XID_ANY && !cx_impl_match( tb->thrown_xid, catch_xid ) )
+    return false;
+  return cx_impl_caught( tb );
+}
 
-  if ( tb->caught_xid == tb->thrown_xid ) {
-    //
-    // This can happen when the same exception is thrown from a "catch" block.
-    // For example, given:
-    //
-    //      try {
-    //        try {
-    //          throw( XID_1 );         // 1
-    //        }
-    //        catch( XID_1 ) {          // 2
-    //          throw();                // 3
-    //        }
-    //        finally {                 // 4
-    //          // ...
-    //        }
-    //      }
-    //      catch( XID_1 ) {            // 5
-    //        // ...
-    //      }
-    //
-    // we want the flow to go from 1 to 5 in sequence. If this check were not
-    // here, we'd loop endlessly between 2-3.
-    //
-    // Once an exception is caught at the current try/catch nesting level, it
-    // can never be recaught at the same level.  By returning "false" for all
-    // catches at the current level, we execute the "finally" block, if any, of
-    // the current level; then the CX_IMPL_FINALLY state will pop us up to the
-    // parent level, if any, where this check will fail (because the parent's
-    // caught_xid will be 0) and we can possibly recatch the exception at the
-    // parent level.
-    //
+bool cx_impl_catch_any_of( int const xids[], unsigned n_xids,
+                           cx_impl_try_block_t *tb ) {
+  assert( xids != NULL );
+  return  cx_impl_catchable( tb ) &&
+          cx_impl_xids_match( xids, n_xids, tb->thrown_xid ) &&
+          cx_impl_caught( tb );
+}
+
+bool cx_impl_catch_range( int lo_xid, int hi_xid, cx_impl_try_block_t *tb ) {
+  assert( lo_xid <= hi_xid );
+  // A single unsigned comparison tests both bounds.
+  return  cx_impl_catchable( tb ) &&
+          (unsigned)tb->thrown_xid - (unsigned)lo_xid <=
+            (unsigned)hi_xid - (unsigned)lo_xid &&
+          cx_impl_caught( tb );
+}
+
+bool cx_impl_co_try_begin( cx_co_try_t *f, char const *try_file,
+                           int try_line ) {
+  assert( f != NULL );
+  assert( f->tb.state == CX_IMPL_INIT );
+  f->tb = (cx_impl_try_block_t){
+    .state = CX_IMPL_TRY,
+    .parent = cx_impl_try_block_head,
+    .catch_xids = cx_impl_co_try_xids,
+    .try_file = try_file,
+    .try_line = try_line
+  };
+  cx_impl_try_block_push( &f->tb );
+  return true;
+}
+
+bool cx_impl_co_try_relink( cx_co_try_t *f ) {
+  assert( f != NULL );
+  if ( f->tb.state == CX_IMPL_INIT )
     return false;
+  assert( cx_impl_try_block_head != &f->tb );
+  f->tb.parent = cx_impl_try_block_head;
+  cx_impl_try_block_push( &f->tb );
+  return true;
+}
+
+void cx_impl_escape( char const *escape_file, int escape_line, int id,
+                     void *value ) {
+  cx_impl_try_block_t *eb = cx_impl_try_block_head;
+  while ( eb != NULL && (eb->state != CX_IMPL_ESCAPE || eb->caught_xid != id) )
+    eb = eb->parent;
+  if ( eb == NULL ) {
+    fprintf( stderr,
+      "%s:%d: no \"escape point\" for escape ID %d (0x%X)\n",
+      escape_file, escape_line, id, (unsigned)id
+    );
+    abort();
   }
+  cx_impl_busy_begin();
+  cx_impl_escape_target = eb;
+  cx_impl_escape_value_ = value;
+  cx_impl_do_escape();
+}
 
-  if ( catch_xid != CX_XID_ANY ) {
-    assert( cx_xid_matcher != NULL );
-    if ( !(*cx_xid_matcher)( tb->thrown_xid, catch_xid ) )
-      return false;
+void* cx_impl_escape_value( void ) {
+  return cx_impl_escape_value_;
+}
+
+void cx_impl_rethrow( cx_site_t const *site, int xid ) {
+  assert( site != NULL );
+  assert( xid != 0 );
+  assert( xid != CX_IMPL_XID_ESCAPE );
+
+  cx_impl_busy_begin();
+  cx_exception_t *const cex = cx_impl_exception();
+  cex->thrown_site = site;
+  cex->thrown_xid = xid;
+  cx_impl_do_throw();
+}
+
+void cx_impl_throw( cx_site_t const *site, int xid, void *user_data ) {
+  assert( site != NULL );
+  assert( xid != 0 );
+  assert( xid != CX_IMPL_XID_ESCAPE );
+
+  cx_impl_busy_begin();
+  cx_exception_t *const cex = cx_impl_exception();
+  cx_impl_cause_release( cex->cause );
+  cex->thrown_site = site;
+  cex->thrown_xid = xid;
+  cex->user_data = user_data;
+  cex->cause = NULL;
+  cex->format = NULL;
+  cex->payload_type = CX_PAYLOAD_NONE;
+  cex->payload_size = 0;
+  cx_impl_context_snapshot();
+  cx_impl_do_throw();
+}
+
+void cx_impl_throw_nested( cx_site_t const *site, int xid,
+                           void *user_data ) {
+  assert( site != NULL );
+  assert( xid != 0 );
+  assert( xid != CX_IMPL_XID_ESCAPE );
+
+  cx_impl_busy_begin();
+  cx_exception_t *const cex = cx_impl_exception();
+  cx_exception_t const *cause = NULL;
+  if ( cex->thrown_site != NULL ) {
+    cx_exception_ptr_t *const xp = cx_impl_cause_alloc();
+    if ( xp == NULL ) {
+      cx_impl_cause_release( cex->cause );
+    }
+    else {
+      xp->cex = *cex;                   // takes over its cause reference
+      atomic_init( &xp->refs, 1 );
+      cause = &xp->cex;
+    }
   }
 
-  tb->state = CX_IMPL_CAUGHT;
-  tb->caught_xid = tb->thrown_xid;
-  return true;
+  cex->thrown_site = site;
+  cex->thrown_xid = xid;
+  cex->user_data = user_data;
+  cex->cause = cause;
+  cex->format = NULL;
+  cex->payload_type = CX_PAYLOAD_NONE;
+  cex->payload_size = 0;
+  cx_impl_context_snapshot();
+  cx_impl_do_throw();
 }
 
-void cx_impl_throw( char const *throw_file, int throw_line, int xid,
-                    void *user_data ) {
-  assert( throw_file != NULL );
-  assert( throw_line > 0 );
+void cx_impl_throw_value( cx_site_t const *site, int xid,
+                          cx_impl_payload_kind_t kind, void const *value,
+                          size_t size ) {
+  assert( site != NULL );
   assert( xid != 0 );
+  assert( xid != CX_IMPL_XID_ESCAPE );
+  assert( value != NULL );
+  assert( size <= CX_PAYLOAD_SIZE_MAX );
 
-  cx_impl_exception = (cx_exception_t){
-    .thrown_file = throw_file,
-    .thrown_line = throw_line,
-    .thrown_xid = xid,
-    .user_data = user_data
-  };
+  cx_impl_busy_begin();
+  cx_exception_t *const cex = cx_impl_exception();
+  cx_impl_cause_release( cex->cause );
+  cex->thrown_site = site;
+  cex->thrown_xid = xid;
+  cex->user_data = NULL;
+  cex->cause = NULL;
+  cex->format = NULL;
+
+  switch ( kind ) {
+    case CX_IMPL_PAYLOAD_SINT:
+    case CX_IMPL_PAYLOAD_UINT:
+      cex->payload.i = cx_impl_payload_int( kind, value, size );
+      cex->payload_type = CX_PAYLOAD_INT;
+      cex->payload_size = sizeof cex->payload.i;
+      break;
+    case CX_IMPL_PAYLOAD_FLOAT:
+      cex->payload.d = *(float const*)value;
+      goto set_double;
+    case CX_IMPL_PAYLOAD_DOUBLE:
+      cex->payload.d = *(double const*)value;
+      goto set_double;
+    case CX_IMPL_PAYLOAD_LDOUBLE:
+      cex->payload.d = (double)*(long double const*)value;
+set_double:
+      cex->payload_type = CX_PAYLOAD_DOUBLE;
+      cex->payload_size = sizeof cex->payload.d;
+      break;
+    case CX_IMPL_PAYLOAD_STRING:;
+      char const *const str = *(char const *const*)value;
+      if ( str == NULL ) {
+        cex->payload_type = CX_PAYLOAD_NONE;
+        cex->payload_size = 0;
+        break;
+      }
+      size_t const len = strnlen( str, CX_PAYLOAD_SIZE_MAX - 1 );
+      // The string may be the payload of the current exception: use memmove.
+      memmove( cex->payload.s, str, len );
+      cex->payload.s[ len ] = '\0';
+      cex->payload_type = CX_PAYLOAD_STRING;
+      cex->payload_size = (unsigned)len + 1;
+      break;
+    case CX_IMPL_PAYLOAD_STRUCT:
+      memmove( cex->payload.bytes, value, size );
+      cex->payload_type = CX_PAYLOAD_STRUCT;
+      cex->payload_size = (unsigned)size;
+      break;
+  } // switch
+
+  cx_impl_context_snapshot();
+  cx_impl_do_throw();
+}
+
+void cx_impl_throwf( cx_site_t const *site, int xid, char const *format,
+                     ... ) {
+  assert( site != NULL );
+  assert( xid != 0 );
+  assert( xid != CX_IMPL_XID_ESCAPE );
+  assert( format != NULL );
+
+  cx_impl_busy_begin();
+  cx_exception_t *const cex = cx_impl_exception();
+  cx_impl_cause_release( cex->cause );
+  cex->thrown_site = site;
+  cex->thrown_xid = xid;
+  cex->user_data = NULL;
+  cex->cause = NULL;
+  cex->format = format;
+  cex->payload_type = CX_PAYLOAD_NONE;
+  cex->payload_size = 0;
+
+  //
+  // Copy only the arguments: formatting is deferred until the message is
+  // actually needed, if ever.
+  //
+  union cx_impl_format_arg *arg = cex->payload.format_args;
+  union cx_impl_format_arg const *const end = arg + CX_THROWF_ARGS_MAX;
+  va_list args;
+  va_start( args, format );
+  for ( char const *f = format; (f = strchr( f, '%' )) != NULL; ) {
+    cx_impl_conv_t conv;
+    cx_impl_conv_parse( f, &conv );
+    f = conv.end;
+    for ( unsigned i = 0; i < conv.n_stars && arg < end; ++i )
+      (arg++)->i = va_arg( args, int );
+    if ( arg == end )
+      break;
+    switch ( cx_impl_conv_kind( conv.conv ) ) {
+      case CX_IMPL_CONV_SINT:
+        switch ( conv.length ) {
+          case 'l': arg->i = va_arg( args, long );      break;
+          case 'q': arg->i = va_arg( args, long long ); break;
+          case 'j': arg->i = va_arg( args, intmax_t );  break;
+          case 't': arg->i = va_arg( args, ptrdiff_t ); break;
+          case 'z': arg->i = va_arg( args, ssize_t );   break;
+          default : arg->i = va_arg( args, int );       break;
+        } // switch
+        break;
+      case CX_IMPL_CONV_UINT:
+        switch ( conv.length ) {
+          case 'l':
+            arg->i = (long long)va_arg( args, unsigned long );
+            break;
+          case 'q':
+            arg->i = (long long)va_arg( args, unsigned long long );
+            break;
+          case 'j':
+            arg->i = (long long)va_arg( args, uintmax_t );
+            break;
+          case 't':
+          case 'z':
+            arg->i = (long long)va_arg( args, size_t );
+            break;
+          default:
+            arg->i = va_arg( args, unsigned );
+            break;
+        } // switch
+        break;
+      case CX_IMPL_CONV_CHAR:
+        arg->i = conv.length == 'l' ?
+          (long long)va_arg( args, wint_t ) : va_arg( args, int );
+        break;
+      case CX_IMPL_CONV_DOUBLE:
+        arg->d = conv.length == 'L' ?
+          (double)va_arg( args, long double ) : va_arg( args, double );
+        break;
+      case CX_IMPL_CONV_PTR:
+        arg->p = va_arg( args, void const* );
+        break;
+      case CX_IMPL_CONV_NONE:
+        continue;
+    } // switch
+    ++arg;
+  } // for
+  va_end( args );
+
+  cx_impl_context_snapshot();
   cx_impl_do_throw();
 }
 
+cx_impl_matcher_scope_t* cx_impl_matcher_scope_pop(
+  cx_impl_matcher_scope_t *ms
+) {
+  assert( ms != NULL );
+  //
+  // Pop ms from the stack of matchers first: should a signal handler throw
+  // in between, the throw then finds ms still open and skips it.
+  //
+  cx_impl_matcher_scope_pop_top( ms );
+  atomic_signal_fence( memory_order_seq_cst );
+  cx_impl_try_block_head = ms->node.parent;
+  return NULL;
+}
+
+cx_impl_matcher_scope_t* cx_impl_matcher_scope_push(
+  cx_impl_matcher_scope_t *ms, cx_xid_matcher_t fn
+) {
+  assert( ms != NULL );
+  ms->node.state = CX_IMPL_SCOPE;
+  ms->node.parent = cx_impl_try_block_head;
+  ms->matcher = fn;
+  ms->prev = cx_impl_matcher_scope_top;
+  cx_impl_try_block_push( &ms->node );
+  cx_impl_matcher_scope_top = ms;
+  return ms;
+}
+
+#if CX_CANCEL_FINALLY && defined(HAVE_PTHREAD_H)
+/**
+ * Resumes exiting the current thread once the #cx_finally block of a #cx_try
+ * block it was unwinding through (see cx_impl_try_unwound()) has finished.
+ *
+ * @remarks This does what glibc's own pthread_cleanup_push() does when not
+ * compiled with `-fexceptions`: the unwinder longjmps to it, it calls its
+ * cleanup routine, then it calls `__pthread_unwind_next()` to unwind to the
+ * next outer cleanup.  Registering then unregistering \a buf links it to the
+ * innermost such cleanup.  Unlike calling `pthread_exit()` again, this
+ * neither nests another exit nor replaces the thread's exit value.
+ */
+_Noreturn
+static void cx_impl_exit_resume( void ) {
+  __pthread_unwind_buf_t buf;
+  __pthread_register_cancel( &buf );
+  __pthread_unregister_cancel( &buf );
+  __pthread_unwind_next( &buf );
+}
+#endif /* CX_CANCEL_FINALLY && HAVE_PTHREAD_H */
+
+#if CX_CANCEL_FINALLY || CX_JMP_BACKEND == CX_JMP_BACKEND_UNWIND
+bool cx_impl_try_unwound( cx_impl_try_block_t *tb ) {
+  assert( tb != NULL );
+#if CX_JMP_BACKEND == CX_JMP_BACKEND_UNWIND
+  if ( tb == cx_impl_unwind_target ) {
+    cx_impl_unwind_target = NULL;
+    cx_impl_busy_end();
+    return true;
+  }
+#endif /* CX_JMP_BACKEND == CX_JMP_BACKEND_UNWIND */
+#if CX_CANCEL_FINALLY
+#ifdef HAVE_PTHREAD_H
+  if ( (tb->state == CX_IMPL_TRY || tb->state == CX_IMPL_THROWN ||
+        tb->state == CX_IMPL_CAUGHT) && cx_impl_try_block_has_finally( tb ) ) {
+    //
+    // A foreign exception is unwinding through tb: assume it's the thread
+    // exiting and run tb's cx_finally block, if any, first.  As with
+    // cx_impl_do_escape(), making the thrown and caught exception IDs the
+    // same makes all cx_catch blocks not match.  Once the cx_finally block
+    // finishes, cx_impl_try_condition() resumes exiting.
+    //
+    tb->state = CX_IMPL_THROWN;
+    tb->thrown_xid = tb->caught_xid = CX_IMPL_XID_EXIT;
+    return true;
+  }
+#endif /* HAVE_PTHREAD_H */
+  cx_impl_try_block_head = tb->parent;
+#endif /* CX_CANCEL_FINALLY */
+  return false;
+}
+#endif /* CX_CANCEL_FINALLY || CX_JMP_BACKEND == CX_JMP_BACKEND_UNWIND */
+
 #define CX_IMPL_TRY_CONDITION_CALLS (                                       \
     1 /* 1st time: INIT -> TRY, run try code. */                            \
   + 1 /* 2nd time: { TRY, THROWN, CAUGHT } -> FINALLY, run finally code. */ \
@@ -259,43 +1657,281 @@ bool cx_impl_try_condition( cx_impl_try_block_t *tb ) {
       return true;
     case CX_IMPL_FINALLY:
       cx_impl_assert_try_block( tb );
+      cx_impl_busy_begin();
       cx_impl_try_block_head = tb->parent;
-      if ( tb->thrown_xid != 0 )
+#if CX_CANCEL_FINALLY && defined(HAVE_PTHREAD_H)
+      if ( tb->thrown_xid == CX_IMPL_XID_EXIT ) {
+        //
+        // Resume exiting: this unwinds through the remaining frames running
+        // their cleanups including the cx_finally blocks of any enclosing
+        // cx_try blocks (via cx_impl_try_unwound()).
+        //
+        cx_impl_exception_clear();
+        cx_impl_busy_end();
+        cx_impl_exit_resume();
+      }
+#endif /* CX_CANCEL_FINALLY && HAVE_PTHREAD_H */
+      if ( tb->thrown_xid != 0 && tb->thrown_xid != CX_IMPL_XID_ESCAPE )
         cx_impl_do_throw();             // rethrow uncaught exception
-      cx_impl_exception = (cx_exception_t){ 0 };
+      cx_impl_exception_clear();
+      if ( tb->thrown_xid == CX_IMPL_XID_ESCAPE )
+        cx_impl_do_escape();            // continue escaping
+      cx_impl_busy_end();
       return false;
+    case CX_IMPL_NOEXCEPT:
+    case CX_IMPL_ESCAPE:
+    case CX_IMPL_SCOPE:
+    case CX_IMPL_CONTEXT:
+      unreachable();
   } // switch
 }
 
 ////////// extern public functions ////////////////////////////////////////////
 
+bool cx_co_catch( cx_co_try_t *f, int xid ) {
+  assert( f != NULL );
+  return f->tb.state == CX_IMPL_THROWN && cx_impl_catch( xid, &f->tb );
+}
+
+void cx_co_try_end( cx_co_try_t *f ) {
+  assert( f != NULL );
+  cx_impl_try_block_t *const tb = &f->tb;
+  assert( tb->state != CX_IMPL_INIT );
+  assert( cx_impl_try_block_head == tb );
+  cx_impl_busy_begin();
+  cx_impl_try_block_head = tb->parent;
+  cx_impl_state_t const state = tb->state;
+  tb->state = CX_IMPL_INIT;
+  if ( state == CX_IMPL_THROWN )
+    cx_impl_do_throw();                 // rethrow uncaught exception
+  if ( state == CX_IMPL_CAUGHT )
+    cx_impl_exception_clear();
+  cx_impl_busy_end();
+}
+
+void cx_co_yield( cx_co_try_t *f ) {
+  assert( f != NULL );
+  if ( f->tb.state == CX_IMPL_INIT )
+    return;
+  assert( cx_impl_try_block_head == &f->tb );
+  cx_impl_try_block_head = f->tb.parent;
+}
+
 cx_exception_t* cx_current_exception( void ) {
-  return cx_impl_exception.thrown_file == NULL ? NULL : &cx_impl_exception;
+  cx_exception_t *const cex = cx_impl_exception();
+  return cex->thrown_site == NULL ? NULL : cex;
+}
+
+char const* cx_exception_context( cx_exception_t const *cex, unsigned i ) {
+  if ( cex == NULL || i >= cex->n_contexts )
+    return NULL;
+  return cx_impl_format(
+    cex->contexts[i].format, cex->contexts[i].args, CX_CONTEXT_ARGS_MAX
+  );
+}
+
+char const* cx_exception_message( cx_exception_t const *cex ) {
+  if ( cex == NULL || cex->format == NULL )
+    return NULL;
+  return cx_impl_format(
+    cex->format, cex->payload.format_args, CX_THROWF_ARGS_MAX
+  );
+}
+
+cx_exception_ptr_t* cx_exception_ptr_capture( void ) {
+  cx_exception_t const *const cex = cx_impl_exception();
+  if ( cex->thrown_site == NULL )
+    return NULL;
+  cx_exception_ptr_t *const xp = cx_impl_xptr_alloc( /*grow=*/true );
+  xp->cex = *cex;
+  cx_impl_cause_add_ref( xp->cex.cause );
+  atomic_init( &xp->refs, 1 );
+  return xp;
+}
+
+cx_exception_ptr_t* cx_exception_ptr_copy( cx_exception_ptr_t *xp ) {
+  assert( xp != NULL );
+  atomic_fetch_add_explicit( &xp->refs, 1, memory_order_relaxed );
+  return xp;
+}
+
+cx_exception_t const* cx_exception_ptr_exception( cx_exception_ptr_t const *xp ) {
+  assert( xp != NULL );
+  return &xp->cex;
+}
+
+void cx_exception_ptr_release( cx_exception_ptr_t *xp ) {
+  while ( xp != NULL &&
+          atomic_fetch_sub_explicit( &xp->refs, 1, memory_order_acq_rel ) == 1 ) {
+    cx_exception_t const *const cause = xp->cex.cause;
+    cx_impl_xptr_pool_t *const pool = xp->pool;
+    if ( pool == cx_impl_xptr_pool ) {
+      xp->next = pool->free_list;
+      pool->free_list = xp;
+    }
+    else {
+      cx_exception_ptr_t *next =
+        atomic_load_explicit( &pool->remote_list, memory_order_relaxed );
+      do {
+        xp->next = next;
+      } while ( !atomic_compare_exchange_weak_explicit(
+                  &pool->remote_list, &next, xp,
+                  memory_order_release, memory_order_relaxed ) );
+    }
+    cx_impl_xptr_pool_release( pool );
+    // Release the reference this exception held to its cause, if any.
+    xp = cause != NULL ? cx_impl_xptr_of( cause ) : NULL;
+  } // while
+}
+
+cx_site_t const* cx_get_sites( size_t *n_sites ) {
+  assert( n_sites != NULL );
+#if defined(__GNUC__) && defined(__ELF__)
+  *n_sites = (size_t)(__stop_cx_sites - __start_cx_sites);
+  return *n_sites > 0 ? __start_cx_sites : NULL;
+#else
+  *n_sites = 0;
+  return NULL;
+#endif /* __GNUC__ && __ELF__ */
 }
 
 cx_terminate_handler_t cx_get_terminate( void ) {
-  return cx_impl_terminate_handler == &cx_impl_default_terminate_handler ?
-    NULL : cx_impl_terminate_handler;
+  cx_terminate_handler_t const fn =
+    atomic_load_explicit( &cx_impl_terminate_handler, memory_order_acquire );
+  return fn == &cx_impl_default_terminate_handler ? NULL : fn;
+}
+
+cx_terminate_handler_t cx_get_thread_terminate( void ) {
+  return cx_impl_thread_terminate_handler;
+}
+
+cx_xid_matcher_t cx_get_thread_xid_matcher( void ) {
+  return cx_impl_thread_xid_matcher;
 }
 
 cx_xid_matcher_t cx_get_xid_matcher( void ) {
-  return cx_xid_matcher == &cx_impl_default_xid_matcher ? NULL : cx_xid_matcher;
+  cx_xid_matcher_t const fn =
+    atomic_load_explicit( &cx_xid_matcher, memory_order_acquire );
+  return fn == &cx_impl_default_xid_matcher ? NULL : fn;
+}
+
+bool cx_invoke( cx_invoke_fn_t fn, void *ctx, cx_exception_t *cex ) {
+  assert( fn != NULL );
+  bool volatile thrown = false;
+  cx_try_catching( false, CX_XID_ANY ) {
+    (*fn)( ctx );
+  }
+  cx_catch() {
+    if ( cex != NULL ) {
+      *cex = *cx_impl_exception();
+      cex->cause = NULL;
+    }
+    thrown = true;
+  }
+  return thrown;
+}
+
+double cx_payload_double( cx_exception_t const *cex ) {
+  return cex != NULL && cex->payload_type == CX_PAYLOAD_DOUBLE ?
+    cex->payload.d : 0;
+}
+
+long long cx_payload_int( cx_exception_t const *cex ) {
+  return cex != NULL && cex->payload_type == CX_PAYLOAD_INT ?
+    cex->payload.i : 0;
+}
+
+void const* cx_payload_ptr( cx_exception_t const *cex ) {
+  return cex != NULL && cex->payload_type == CX_PAYLOAD_STRUCT ?
+    cex->payload.bytes : NULL;
+}
+
+char const* cx_payload_string( cx_exception_t const *cex ) {
+  return cex != NULL && cex->payload_type == CX_PAYLOAD_STRING ?
+    cex->payload.s : NULL;
+}
+
+void cx_rethrow_ptr( cx_exception_ptr_t *xp ) {
+  assert( xp != NULL );
+  cx_impl_busy_begin();
+  cx_exception_t *const cex = cx_impl_exception();
+  cx_impl_cause_release( cex->cause );
+  *cex = xp->cex;
+  cx_impl_cause_add_ref( cex->cause );
+  cx_exception_ptr_release( xp );
+  cx_impl_do_throw();
 }
 
 cx_terminate_handler_t cx_set_terminate( cx_terminate_handler_t fn ) {
-  cx_terminate_handler_t const rv = cx_get_terminate();
-  cx_impl_terminate_handler = fn == NULL ?
-    &cx_impl_default_terminate_handler : fn;
+  cx_terminate_handler_t const rv = atomic_exchange_explicit(
+    &cx_impl_terminate_handler,
+    fn == NULL ? &cx_impl_default_terminate_handler : fn,
+    memory_order_acq_rel
+  );
+  return rv == &cx_impl_default_terminate_handler ? NULL : rv;
+}
+
+cx_terminate_handler_t cx_set_thread_terminate( cx_terminate_handler_t fn ) {
+  cx_terminate_handler_t const rv = cx_impl_thread_terminate_handler;
+  cx_impl_thread_terminate_handler = fn;
   return rv;
 }
 
-cx_xid_matcher_t cx_set_xid_matcher( cx_xid_matcher_t fn ) {
-  cx_xid_matcher_t const rv = cx_get_xid_matcher();
-  cx_xid_matcher = fn == NULL ? &cx_impl_default_xid_matcher : fn;
+cx_xid_matcher_t cx_set_thread_xid_matcher( cx_xid_matcher_t fn ) {
+  cx_xid_matcher_t const rv = cx_impl_thread_xid_matcher;
+  cx_impl_thread_xid_matcher = fn;
   return rv;
 }
 
+cx_xid_matcher_t cx_set_xid_matcher( cx_xid_matcher_t fn ) {
+  cx_xid_matcher_t const rv = atomic_exchange_explicit(
+    &cx_xid_matcher,
+    fn == NULL ? &cx_impl_default_xid_matcher : fn,
+    memory_order_acq_rel
+  );
+  return rv == &cx_impl_default_xid_matcher ? NULL : rv;
+}
+
+size_t cx_site_id( cx_site_t const *site ) {
+#if defined(__GNUC__) && defined(__ELF__)
+  if ( site >= __start_cx_sites && site < __stop_cx_sites )
+    return (size_t)(site - __start_cx_sites);
+#else
+  (void)site;
+#endif /* __GNUC__ && __ELF__ */
+  return SIZE_MAX;
+}
+
+void cx_state_swap( cx_fiber_state_t *from, cx_fiber_state_t *to ) {
+  assert( from != NULL );
+  assert( to != NULL );
+  // Load first in case from == to.
+  cx_impl_try_block_t *const try_block_head = to->try_block_head;
+  cx_impl_matcher_scope_t *const matcher_scope_top = to->matcher_scope_top;
+  cx_impl_try_block_t *const escape_target = to->escape_target;
+  void *const escape_value = to->escape_value;
+  cx_impl_context_scope_t *const context_top = to->context_top;
+  cx_exception_t *const exception = to->exception != NULL ?
+    to->exception : &to->own_exception;
+
+  from->try_block_head    = cx_impl_try_block_head;
+  from->matcher_scope_top = cx_impl_matcher_scope_top;
+  from->escape_target     = cx_impl_escape_target;
+  from->escape_value      = cx_impl_escape_value_;
+  from->context_top       = cx_impl_context_top;
+  from->exception         = cx_impl_exception();
+
+  cx_impl_try_block_head    = try_block_head;
+  cx_impl_matcher_scope_top = matcher_scope_top;
+  cx_impl_escape_target     = escape_target;
+  cx_impl_escape_value_     = escape_value;
+  cx_impl_context_top       = context_top;
+  cx_impl_exception_        = exception;
+}
+
 extern inline void* cx_user_data( void );
+extern inline char const* cx_exception_file( cx_exception_t const* );
+extern inline int cx_exception_line( cx_exception_t const* );
 
 /// @endcond
 
@@ -28,7 +28,9 @@
  */
 
 // standard
+#include <limits.h>
 #include <setjmp.h>
+#include <signal.h>
 #include <stdbool.h>
 #include <stddef.h>
 
@@ -83,6 +85,149 @@ extern "C" {
 # define CX_USE_TRADITIONAL_KEYWORDS    0
 #endif /* CX_USE_TRADITIONAL_KEYWORDS */
 
+#if !defined(CX_INLINE_FAST_PATH)
+  /**
+   * If defined to 1, the state transitions of a #cx_try block when no
+   * exception is thrown are done by `static inline` functions rather than by
+   * calling out-of-line functions; the #cx_try block's jump buffer is also not
+   * zero-filled.  Handling a thrown exception is still done out-of-line.
+   *
+   * Unlike #CX_JMP_BACKEND, this need not be defined identically when
+   * compiling both the library and code that uses it, i.e., it may be defined
+   * per translation unit.
+   *
+   * Defaults to 0.
+   */
+# define CX_INLINE_FAST_PATH      0
+#endif /* CX_INLINE_FAST_PATH */
+
+#if !defined(CX_CANCEL_FINALLY)
+  /**
+   * If defined to 1, each #cx_try block uses `__attribute__((cleanup))` so
+   * that it notices when the stack is being unwound through it by a foreign
+   * exception.  This is assumed to be its thread exiting, i.e., it's been
+   * cancelled via `pthread_cancel()` or called `pthread_exit()`: the block's
+   * #cx_finally block, if any, is executed (but no #cx_catch blocks), then
+   * unwinding resumes with the thread's exit value intact.  Hence, the
+   * #cx_finally blocks of all open #cx_try blocks are executed in order,
+   * innermost first, interleaved with any other cleanups, e.g., those of
+   * `pthread_cleanup_push()`, before the thread exits.  This makes it safe to
+   * cancel threads that have, say, locks to release in #cx_finally blocks.
+   *
+   * Thrown exceptions are still propagated by jumping directly to the #cx_try
+   * block that will handle them, so cleanups in between are _not_ run.
+   *
+   * @note Consequently, a C++ exception must never propagate through a
+   * #cx_try block.
+   *
+   * @note Requires GCC or Clang, glibc (whose thread exit unwinding it
+   * resumes via its `__pthread_unwind_next()`), and that both the library
+   * and all code that uses it be compiled with `-fexceptions`.
+   *
+   * @warning Since it changes how #cx_try blocks are declared, it _must_ be
+   * defined identically when compiling both the library and all code that
+   * uses it.
+   *
+   * Defaults to 0.
+   */
+# define CX_CANCEL_FINALLY        0
+#endif /* CX_CANCEL_FINALLY */
+
+#ifdef DOXYGEN
+  /**
+   * If defined, the name of a function (or function-like macro) having the
+   * same signature as \ref cx_xid_matcher_t that #cx_catch uses to match
+   * exception IDs at compile-time instead of calling the current \ref
+   * cx_xid_matcher_t via a pointer.  The function is typically `static
+   * inline` so the match can be inlined, e.g.:
+   *  ```c
+   *  static inline bool my_cx_xid_matcher( int thrown_xid, int catch_xid ) {
+   *    if ( (catch_xid & 0x00FF) == 0x00 )
+   *      thrown_xid &= 0xFF00;
+   *    return thrown_xid == catch_xid;
+   *  }
+   *  #define CX_XID_MATCHER  my_cx_xid_matcher
+   *  #include <c_exception.h>
+   *  ```
+   * If not defined, the matcher set via cx_set_xid_matcher() is used.
+   *
+   * @note It may be defined per translation unit.  However, since #cx_throw
+   * uses the library's matcher to find a #cx_try_catching block that can
+   * handle an exception, if it's not also defined when compiling the library,
+   * the same matcher should also be set via cx_set_xid_matcher().
+   *
+   * @sa cx_set_xid_matcher()
+   */
+# define CX_XID_MATCHER
+#endif /* DOXYGEN */
+
+/**
+ * Value for #CX_JMP_BACKEND to use the C library's `setjmp()` and `longjmp()`.
+ */
+#define CX_JMP_BACKEND_LIBC       0
+
+/**
+ * Value for #CX_JMP_BACKEND to use the compiler's `__builtin_setjmp()` and
+ * `__builtin_longjmp()`.  These save only about five words (frame pointer,
+ * stack pointer, and resume address) and are expanded inline.
+ *
+ * @note Requires GCC or Clang.
+ */
+#define CX_JMP_BACKEND_BUILTIN    1
+
+/**
+ * Value for #CX_JMP_BACKEND to use POSIX `sigsetjmp()` (without saving the
+ * signal mask) and `siglongjmp()`.
+ */
+#define CX_JMP_BACKEND_SIGSETJMP  2
+
+/**
+ * Value for #CX_JMP_BACKEND to use a minimal, hand-written context
+ * save/restore that saves only the frame pointer, stack pointer, and resume
+ * address.  The remaining callee-saved registers are instead saved by the
+ * function containing the #cx_try.  This makes an entire \ref
+ * cx_impl_try_block fit within 64 bytes.
+ *
+ * @note Requires GCC on x86-64 Linux.
+ *
+ * @warning It is incompatible with hardware shadow stacks.
+ */
+#define CX_JMP_BACKEND_X86_64     3
+
+/**
+ * Value for #CX_JMP_BACKEND to use the platform's unwinder: entering a #cx_try
+ * saves only the resume address; #cx_throw unwinds the stack (via
+ * `_Unwind_ForcedUnwind()`) to the function containing the #cx_try block that
+ * will handle the exception whose cleanup then resumes it with the frame
+ * pointer and stack pointer the unwinder restored.  Hence entering a #cx_try
+ * block is cheaper, throwing is costlier, and the cleanups of any
+ * `__attribute__((cleanup))` variables in between are run.
+ *
+ * @note Requires GCC on x86-64 Linux and that both the library and all code
+ * that uses it be compiled with `-fexceptions`.  A function not so compiled
+ * is unwound through without running its cleanups.
+ *
+ * @warning A cleanup run while unwinding must not itself throw, even if it
+ * would catch its own exception.
+ *
+ * @warning It is incompatible with hardware shadow stacks.
+ */
+#define CX_JMP_BACKEND_UNWIND     4
+
+#if !defined(CX_JMP_BACKEND)
+  /**
+   * The mechanism used by #cx_try to save, and #cx_throw to restore, the
+   * execution context.  It must be one of #CX_JMP_BACKEND_LIBC (the default),
+   * #CX_JMP_BACKEND_BUILTIN, #CX_JMP_BACKEND_SIGSETJMP,
+   * #CX_JMP_BACKEND_X86_64, or #CX_JMP_BACKEND_UNWIND.
+   *
+   * @warning Since it changes the layout of internal data structures, it
+   * _must_ be defined identically when compiling both the library and all code
+   * that uses it.
+   */
+# define CX_JMP_BACKEND           CX_JMP_BACKEND_LIBC
+#endif /* CX_JMP_BACKEND */
+
 #if !defined(__cplusplus) && CX_USE_TRADITIONAL_KEYWORDS
 # define try                      cx_try
 # define catch(...)               cx_catch( __VA_ARGS__ )
@@ -95,24 +240,210 @@ extern "C" {
  */
 #define CX_XID_ANY                0
 
+/**
+ * The exception ID thrown by #cx_check_cancel when its token has been
+ * cancelled.
+ *
+ * @note Exception IDs from `INT_MIN` through `-0x7FFFFF00` are reserved for use
+ * by this library.
+ */
+#define CX_XID_CANCELLED          -0x7FFFFF00
+
+/**
+ * The exception ID thrown when the deadline of a #cx_try_deadline block has
+ * passed.
+ */
+#define CX_XID_TIMEOUT            -0x7FFFFF01
+
+/**
+ * The number of causes retained by #cx_throw_nested() for which each thread
+ * preallocates storage.  (It's shared with \ref cx_exception_ptr_t objects.)
+ */
+#define CX_CAUSE_MAX              32
+
+/**
+ * The maximum size in bytes of a payload thrown via #cx_throw_value().
+ */
+#define CX_PAYLOAD_SIZE_MAX       64
+
+/**
+ * The maximum number of arguments following the format of #cx_throwf().
+ */
+#define CX_THROWF_ARGS_MAX        8
+
+/**
+ * The maximum size in bytes, including the terminating null, of a message
+ * returned by cx_exception_message().
+ */
+#define CX_MESSAGE_SIZE_MAX       256
+
+/**
+ * The maximum number of arguments following the format of #cx_context.
+ */
+#define CX_CONTEXT_ARGS_MAX       3
+
+/**
+ * The maximum number of #cx_context scopes, innermost first, recorded by a
+ * throw.
+ */
+#define CX_CONTEXT_MAX            4
+
+/**
+ * The type of the payload, if any, of a \ref cx_exception.
+ *
+ * @sa #cx_throw_value()
+ */
+enum cx_payload_type {
+  CX_PAYLOAD_NONE,                      ///< No payload.
+  CX_PAYLOAD_INT,                       ///< An integer.
+  CX_PAYLOAD_DOUBLE,                    ///< A floating-point number.
+  CX_PAYLOAD_STRING,                    ///< A string.
+  CX_PAYLOAD_STRUCT                     ///< Any other object.
+};
+typedef enum cx_payload_type cx_payload_type_t;
+
+/**
+ * A static descriptor of a place whence an exception is thrown: each use of
+ * #cx_throw(), #cx_throw_nested(), #cx_throwf(), #cx_throw_value(), and
+ * #cx_try_deadline has exactly one.
+ *
+ * @sa cx_exception::thrown_site
+ * @sa cx_site_id()
+ * @sa cx_get_sites()
+ */
+struct cx_site {
+  char const *file;                     ///< File containing the site.
+  char const *func;                     ///< Function containing the site.
+  int         line;                     ///< Line number within \ref file.
+};
+typedef struct cx_site cx_site_t;
+
 /**
  * Contains information about a thrown exception.
  */
 struct cx_exception {
-  /// The file whence the exception was thrown.
-  char const *thrown_file;
-
-  /// The line number within \ref thrown_file whence the exception was thrown.
-  int         thrown_line;
+  /// The site whence the exception was thrown or rethrown, or that of the
+  /// #cx_noexcept it escaped, if any.
+  ///
+  /// @sa cx_exception_file()
+  /// @sa cx_exception_line()
+  cx_site_t const *thrown_site;
 
   /// The exception ID that was thrown.
   int         thrown_xid;
 
   /// Optional user-data passed via #cx_throw.
   void       *user_data;
+
+  /**
+   * The exception, if any, that was in progress when this one was thrown via
+   * #cx_throw_nested(); in turn, it may have a cause.
+   *
+   * @remarks It's valid for as long as this exception is in progress or a
+   * \ref cx_exception_ptr_t that captured it exists.
+   */
+  struct cx_exception const *cause;
+
+  /// The type of \ref payload, if any.
+  cx_payload_type_t payload_type;
+
+  /// The size in bytes of \ref payload.
+  unsigned          payload_size;
+
+  /// The `printf()` format passed to #cx_throwf(), if any.
+  char const       *format;
+
+  /// Optional payload copied via #cx_throw_value().
+  union {
+    long long       i;                  ///< #CX_PAYLOAD_INT.
+    double          d;                  ///< #CX_PAYLOAD_DOUBLE.
+    char            s[ CX_PAYLOAD_SIZE_MAX ]; ///< #CX_PAYLOAD_STRING.
+    unsigned char   bytes[ CX_PAYLOAD_SIZE_MAX ]; ///< #CX_PAYLOAD_STRUCT.
+    max_align_t     align;              ///< Aligns \ref bytes for any type.
+
+    /// @cond DOXYGEN_IGNORE
+    union cx_impl_format_arg {
+      long long           i;
+      double              d;
+      void const         *p;
+    } format_args[ CX_THROWF_ARGS_MAX ]; ///< Arguments for \ref format.
+    /// @endcond
+  } payload;
+
+  /// The number of #cx_context scopes that were active when thrown, at most
+  /// #CX_CONTEXT_MAX.
+  /// @sa cx_exception_context()
+  unsigned    n_contexts;
+
+  /// @cond DOXYGEN_IGNORE
+  // Must be last: it's not cleared when the exception is done with.
+  struct cx_impl_context {
+    char const               *format;
+    union cx_impl_format_arg  args[ CX_CONTEXT_ARGS_MAX ];
+  } contexts[ CX_CONTEXT_MAX ];         // innermost first
+  /// @endcond
 };
 typedef struct cx_exception cx_exception_t;
 
+/**
+ * A reference-counted copy of a thrown exception that remains valid after the
+ * exception is no longer in progress and can be passed to other threads.
+ *
+ * @sa cx_exception_ptr_capture()
+ */
+typedef struct cx_exception_ptr cx_exception_ptr_t;
+
+/**
+ * The state of C Exception for a fiber (a.k.a. coroutine or green thread)
+ * that is saved and restored when switching fibers via cx_state_swap().
+ *
+ * @remarks Its fields are for the implementation only.  It contains the
+ * fiber's own current exception, so it must not be moved once used.
+ *
+ * @sa #CX_FIBER_STATE_INIT
+ * @sa cx_state_swap()
+ */
+struct cx_fiber_state {
+  /// @cond DOXYGEN_IGNORE
+  struct cx_impl_try_block     *try_block_head;
+  struct cx_impl_matcher_scope *matcher_scope_top;
+  struct cx_impl_try_block     *escape_target;
+  void                         *escape_value;
+  struct cx_impl_context_scope *context_top;
+  cx_exception_t               *exception;      // NULL for own_exception
+  cx_exception_t                own_exception;
+  /// @endcond
+};
+typedef struct cx_fiber_state cx_fiber_state_t;
+
+/**
+ * Initializer for a \ref cx_fiber_state of a new fiber.
+ */
+#define CX_FIBER_STATE_INIT       { .try_block_head = NULL }
+
+/**
+ * A "try" frame for a stackless coroutine whose storage lives in the
+ * coroutine's context rather than on the stack.
+ *
+ * @sa #CX_CO_TRY_INIT
+ * @sa #cx_co_try()
+ */
+typedef struct cx_co_try cx_co_try_t;
+
+/**
+ * Initializer for a \ref cx_co_try_t.
+ */
+#define CX_CO_TRY_INIT            { .tb = { .state = CX_IMPL_INIT } }
+
+/**
+ * The signature for a function called by cx_invoke().
+ *
+ * @param ctx The context pointer passed to cx_invoke().
+ *
+ * @sa cx_invoke()
+ */
+typedef void (*cx_invoke_fn_t)( void *ctx );
+
 /**
  * The signature for a "terminate handler" function that is called by
  * cx_terminate().
@@ -192,6 +523,7 @@ typedef bool (*cx_xid_matcher_t)( int thrown_xid, int catch_xid );
  *  }
  *  printf( "n = %d\n", n );
  *  ```
+ * Alternatively, use cx_invoke().
  *
  * @warning Within a function that uses a <code>%cx_try</code> block, you must
  * _never_ use variable-length arrays.
@@ -231,14 +563,93 @@ typedef bool (*cx_xid_matcher_t)( int thrown_xid, int catch_xid );
  * @sa #cx_cancel_try()
  * @sa #cx_catch()
  * @sa #cx_finally
+ * @sa cx_invoke()
  * @sa #cx_throw()
  */
-#define cx_try                                            \
-  for ( cx_impl_try_block_t cx_tb =                       \
-          { .try_file = __FILE__, .try_line = __LINE__ }; \
-        cx_impl_try_condition( &cx_tb ); )                \
-    if ( cx_tb.state != CX_IMPL_FINALLY )                 \
-      if ( setjmp( cx_tb.env ) == 0 )
+#define cx_try                    CX_IMPL_TRY( NULL )
+
+/**
+ * Begins a "try" block like #cx_try, but additionally declares both the
+ * exception IDs it catches and whether it has a #cx_finally block.
+ *
+ * @remarks
+ * @parblock
+ * When an exception is thrown, a search is first made up the chain of
+ * enclosing <code>%cx_try</code> blocks for the first one that could possibly
+ * handle the exception; control is then transferred directly to it.  A
+ * declared <code>%cx_try_catching</code> block whose exception IDs don't match
+ * the thrown exception ID and that has no #cx_finally block is skipped entirely
+ * rather than being entered only to rethrow the exception to its parent.  For
+ * example:
+ *  ```c
+ *  cx_try_catching( false, EX_FILE_NOT_FOUND, EX_FILE_PERMISSION ) {
+ *    // ...
+ *  }
+ *  cx_catch( EX_FILE_NOT_FOUND ) {
+ *    // ...
+ *  }
+ *  cx_catch( EX_FILE_PERMISSION ) {
+ *    // ...
+ *  }
+ *  ```
+ * The exception IDs are matched using the current \ref cx_xid_matcher_t, if
+ * any.  A plain #cx_try block is never skipped.
+ * @endparblock
+ *
+ * @param FINALLY If `true`, the block has a #cx_finally block, hence it's
+ * never skipped, but its #cx_catch blocks are still declared; if `false`, it
+ * _must not_ have one.
+ * @param ... One or more exception IDs that the #cx_catch blocks catch.
+ *
+ * @warning The exception IDs _must_ include every exception ID caught by a
+ * #cx_catch block and \a FINALLY must be `true` if there is a #cx_finally
+ * block; otherwise a thrown exception may skip them.
+ *
+ * @sa #cx_catch()
+ * @sa #cx_try
+ */
+#define cx_try_catching(FINALLY,...)                                  \
+  CX_IMPL_TRY( ((int const[]){ CX_IMPL_NARG( __VA_ARGS__ ), !!(FINALLY),  \
+                               __VA_ARGS__ }) )
+
+/**
+ * Begins a "try" block like #cx_try, but uses \a FN to match exception IDs
+ * for the #cx_catch blocks of both it and any "try" blocks executed within it
+ * (on this thread only).  For example, rather than:
+ *  ```c
+ *  cx_xid_matcher_t const prev = cx_set_xid_matcher( &my_cx_xid_matcher );
+ *  cx_try {
+ *    // ...
+ *  }
+ *  cx_catch( EX_FILE_ANY ) {
+ *    // ...
+ *  }
+ *  cx_set_xid_matcher( prev );
+ *  ```
+ * that races with other threads, do:
+ *  ```c
+ *  cx_try_with_matcher( &my_cx_xid_matcher ) {
+ *    // ...
+ *  }
+ *  cx_catch( EX_FILE_ANY ) {
+ *    // ...
+ *  }
+ *  ```
+ *
+ * @param FN The \ref cx_xid_matcher_t to use or NULL for the default.
+ *
+ * @note It takes precedence over both cx_set_thread_xid_matcher() and
+ * cx_set_xid_matcher(), but not #CX_XID_MATCHER.
+ *
+ * @sa cx_set_thread_xid_matcher()
+ * @sa cx_set_xid_matcher()
+ * @sa #cx_try
+ */
+#define cx_try_with_matcher(FN)                                         \
+  for ( cx_impl_matcher_scope_t cx_ms CX_IMPL_SCOPE_CLEANUP,            \
+          *volatile cx_msp = cx_impl_matcher_scope_push( &cx_ms, (FN) ); \
+        cx_msp != NULL; cx_msp = cx_impl_matcher_scope_pop( cx_msp ) )  \
+    CX_IMPL_TRY( NULL )
 
 /**
  * Begins a "catch" block possibly catching an exception and executing the code
@@ -246,7 +657,7 @@ typedef bool (*cx_xid_matcher_t)( int thrown_xid, int catch_xid );
  *
  * @remarks
  * @parblock
- * This can be used in one of two ways:
+ * This can be used in one of three ways:
  *
  *  1. With an exception ID:
  *      @code
@@ -254,7 +665,14 @@ typedef bool (*cx_xid_matcher_t)( int thrown_xid, int catch_xid );
  *      @endcode
  *     that catches the given exception ID.
  *
- *  2. With no exception ID:
+ *  2. With up to #CX_IMPL_NARG_MAX exception IDs:
+ *      @code
+ *      cx_catch( EX_FILE_NOT_FOUND, EX_FILE_PERMISSION ) {
+ *      @endcode
+ *     that catches any of the given exception IDs.  The IDs are all tested in
+ *     a single call.
+ *
+ *  3. With no exception ID:
  *      @code
  *      cx_catch() {
  *      @endcode
@@ -286,7 +704,23 @@ typedef bool (*cx_xid_matcher_t)( int thrown_xid, int catch_xid );
  * @sa #cx_throw()
  * @sa #cx_try
  */
-#define cx_catch(...)             CX_IMPL_DEF_ARGS(CX_IMPL_CATCH_, __VA_ARGS__)
+#define cx_catch(...) \
+  CX_IMPL_DEF_ARGS_01N(CX_IMPL_CATCH_, __VA_ARGS__)
+
+/**
+ * Begins a "catch" block like #cx_catch, but catches any exception whose ID is
+ * in the given range.
+ *
+ * @remarks The range is tested directly: the current \ref cx_xid_matcher_t,
+ * if any, is _not_ used.
+ *
+ * @param LO The lowest exception ID to catch.
+ * @param HI The highest exception ID to catch.
+ *
+ * @sa #cx_catch()
+ */
+#define cx_catch_range(LO,HI) \
+  else if ( cx_impl_catch_range( (LO), (HI), &cx_tb ) )
 
 /**
  * Begins a "finally" block always executing the code in the block after the
@@ -331,7 +765,8 @@ typedef bool (*cx_xid_matcher_t)( int thrown_xid, int catch_xid );
  *     @code
  *      cx_throw( EX_FILE_NOT_FOUND );
  *     @endcode
- *     that throws a new exception.  It may be any non-zero value.
+ *     that throws a new exception.  It may be any non-zero value that isn't
+ *     reserved (see #CX_XID_CANCELLED).
  *
  *  2. With an exception ID and user-data:
  *     @code
@@ -363,6 +798,134 @@ typedef bool (*cx_xid_matcher_t)( int thrown_xid, int catch_xid );
  */
 #define cx_throw(...)             CX_IMPL_DEF_ARGS(CX_IMPL_THROW_, __VA_ARGS__)
 
+/**
+ * Throws a new exception from within either a #cx_catch or #cx_finally block
+ * retaining the current exception, if any, as its \ref cx_exception::cause
+ * "cause".  For example:
+ *  ```c
+ *  cx_try {
+ *    read_config( path );
+ *  }
+ *  cx_catch( EX_FILE_NOT_FOUND ) {
+ *    cx_throw_nested( EX_CONFIG );
+ *  }
+ *  ```
+ * Catchers of `EX_CONFIG` can then walk the chain of causes:
+ *  ```c
+ *  for ( cx_exception_t const *cex = cx_current_exception(); cex != NULL;
+ *        cex = cex->cause ) {
+ *    // ...
+ *  }
+ *  ```
+ * It may be used in either of two ways:
+ *
+ *  1. With an exception ID:
+ *     @code
+ *      cx_throw_nested( EX_CONFIG );
+ *     @endcode
+ *
+ *  2. With an exception ID and user-data:
+ *     @code
+ *      cx_throw_nested( EX_CONFIG, path );
+ *     @endcode
+ *
+ * Unlike #cx_throw, the new exception doesn't inherit the user-data of the
+ * current exception: it's still available via the cause.
+ *
+ * @remarks The causes come from a per-thread pool (see #CX_CAUSE_MAX), so a
+ * nested throw doesn't allocate memory.  If the pool is exhausted, the
+ * oldest cause in the chain other than the original (innermost) one is
+ * dropped to make room or, if it's shared with a captured \ref
+ * cx_exception_ptr_t, the new exception has no cause.
+ *
+ * @sa #cx_throw()
+ * @sa cx_exception::cause
+ */
+#define cx_throw_nested(...) \
+  CX_IMPL_DEF_ARGS(CX_IMPL_THROW_NESTED_, __VA_ARGS__)
+
+/**
+ * Throws an exception with a `printf()`-style message that is formatted only
+ * if it's actually needed, i.e., when cx_exception_message() is called or the
+ * default terminate handler is called:
+ *  ```c
+ *  cx_throwf( EX_BAD_INDEX, "index %zu out of range [0,%zu)", i, n );
+ *  ```
+ * Only the format and the arguments are recorded by the throw.
+ *
+ * @param XID The exception ID to throw.  It may be any non-zero value that
+ * isn't reserved (see #CX_XID_CANCELLED).
+ * @param ... The format followed by at most #CX_THROWF_ARGS_MAX arguments.
+ * The format must be a string literal (or otherwise have static storage
+ * duration).
+ *
+ * @note A `long double` argument is recorded as a `double`.  A `%n`
+ * conversion is ignored.
+ *
+ * @warning Like user-data, the string to which a `%s` argument points must
+ * _not_ be a local variable that will go out of scope.
+ *
+ * @sa cx_exception_message()
+ * @sa #cx_throw()
+ */
+#define cx_throwf(XID,...)                                              \
+  do {                                                                  \
+    _Static_assert( CX_IMPL_NARG( __VA_ARGS__ ) <= CX_THROWF_ARGS_MAX + 1,\
+                    "cx_throwf() has too many arguments" );             \
+    CX_IMPL_SITE_CALL( cx_impl_throwf, (XID), __VA_ARGS__ );            \
+  } while (0)
+
+/**
+ * Throws an exception with a payload that is _copied_ into the thread-local
+ * \ref cx_exception, hence it may be a local variable or an rvalue:
+ *  ```c
+ *  cx_throw_value( EX_BAD_INDEX, i );
+ *  cx_throw_value( EX_BAD_VALUE, 1.5 );
+ *  cx_throw_value( EX_FILE_NOT_FOUND, path );
+ *  cx_throw_value( EX_PARSE, (struct parse_error){ .line = 42, .col = 7 } );
+ *  ```
+ * and retrieved via cx_payload_int(), cx_payload_double(),
+ * cx_payload_string(), or cx_payload_ptr() respectively:
+ *  ```c
+ *  cx_catch( EX_PARSE ) {
+ *    struct parse_error const *const pe =
+ *      cx_payload_ptr( cx_current_exception() );
+ *    // ...
+ *  }
+ *  ```
+ *
+ * @param XID The exception ID to throw.  It may be any non-zero value that
+ * isn't reserved (see #CX_XID_CANCELLED).
+ * @param ... The value to copy.  (It's variadic only so a compound literal
+ * containing commas may be given.)  It may be:
+ *  + An integer is stored as `long long` (#CX_PAYLOAD_INT).
+ *  + A floating-point number is stored as `double` (#CX_PAYLOAD_DOUBLE).
+ *  + A `char*` (or array of `char`) has at most #CX_PAYLOAD_SIZE_MAX - 1
+ *    characters of the string to which it points copied (#CX_PAYLOAD_STRING).
+ *    If the pointer is null, there is no payload.
+ *  + Anything else (a structure, union, or non-`char` pointer) has its bytes
+ *    copied (#CX_PAYLOAD_STRUCT).  Its size must be at most
+ *    #CX_PAYLOAD_SIZE_MAX bytes or it won't compile.
+ *
+ * @remarks Unlike #cx_throw with user-data, no heap allocation is needed for
+ * an object to outlive the scope whence it's thrown.  Rethrowing via
+ * <code>%cx_throw()</code> retains the payload.
+ *
+ * @note Requires GCC, Clang, or C23; it can't be used from C++.
+ *
+ * @sa #cx_throw()
+ */
+#define cx_throw_value(XID,...)                                         \
+  do {                                                                  \
+    CX_IMPL_AUTO const cx_pv = (__VA_ARGS__);                           \
+    _Static_assert( sizeof cx_pv <= CX_PAYLOAD_SIZE_MAX,                \
+                    "cx_throw_value() payload too big" );               \
+    CX_IMPL_SITE_CALL(                                                  \
+      cx_impl_throw_value, (XID), CX_IMPL_PAYLOAD_KIND( cx_pv ),        \
+      &cx_pv, sizeof cx_pv                                              \
+    );                                                                  \
+  } while (0)
+
 /**
  * Cancels a current #cx_try, #cx_catch, or #cx_finally block in the current
  * scope allowing you to then safely `break`, `goto` out of the block, or
@@ -407,57 +970,626 @@ typedef bool (*cx_xid_matcher_t)( int thrown_xid, int catch_xid );
 #define cx_cancel_try()           cx_impl_cancel_try( &cx_tb )
 
 /**
- * Gets the current exception, if any.
+ * Begins a "noexcept" block: if an exception is thrown within the block that
+ * isn't caught within the block, cx_terminate() is called.  For example:
+ *  ```c
+ *  static int compare_items( void const *i_a, void const *i_b ) {
+ *    int rv = 0;
+ *    cx_noexcept {
+ *      rv = compare_items_impl( i_a, i_b );
+ *    }
+ *    return rv;
+ *  }
+ *  ```
  *
- * @return If an exception is in progress, returns a pointer to it; otherwise
- * returns NULL.
+ * @remarks Unlike a #cx_try block, no execution context is saved, so entering
+ * a <code>%cx_noexcept</code> block costs only a few stores.
  *
- * @sa cx_user_data()
- */
-cx_exception_t* cx_current_exception( void );
-
-/**
- * Gets the current \ref cx_terminate_handler_t, if any.
+ * @note The \ref cx_exception::thrown_site "thrown_site" of the exception
+ * passed to the terminate handler is that of the <code>%cx_noexcept</code>
+ * and its \ref cx_site::func "func" is NULL.
  *
- * @return Returns said handler or NULL if none.
+ * @warning Within a <code>%cx_noexcept</code> block, you must _never_ `break`
+ * unless it's within your own loop or `switch`, `goto` outside the block, nor
+ * `return` from the function.
  *
  * @sa cx_set_terminate()
- * @sa cx_terminate()
+ * @sa #cx_try
  */
-cx_terminate_handler_t cx_get_terminate( void );
+#define cx_noexcept                                           \
+  for ( cx_impl_try_block_t cx_nb CX_IMPL_TRY_CLEANUP,         \
+          *volatile cx_nbp =                                    \
+            cx_impl_noexcept_enter( &cx_nb, __FILE__, __LINE__ ); \
+        cx_nbp != NULL; cx_nbp = cx_impl_noexcept_exit( cx_nbp ) )
 
 /**
- * Gets the current \ref cx_xid_matcher_t, if any.
+ * Begins a "context" block: if an exception is thrown within the block, a
+ * `printf()`-style description of what was being done is recorded by the
+ * throw so it can be reported.  For example:
+ *  ```c
+ *  cx_context( "while reading \"%s\"", path ) {
+ *    for ( unsigned n = 1; read_record( f, &r ); ++n ) {
+ *      cx_context( "record %u", n ) {
+ *        parse_record( &r );           // may throw
+ *      }
+ *    }
+ *  }
+ *  ```
+ * and retrieved via cx_exception_context().  The default terminate handler
+ * also prints them.
  *
- * @return Returns said function or NULL if none.
+ * @remarks Like #cx_throwf(), only the format and the arguments are recorded,
+ * so entering a <code>%cx_context</code> block costs only a few stores; the
+ * description is formatted only if it's actually needed.  When thrown, the
+ * innermost #CX_CONTEXT_MAX blocks are copied into the \ref cx_exception.
  *
- * @sa cx_set_xid_matcher()
- */
-cx_xid_matcher_t cx_get_xid_matcher( void );
-
-/**
- * Sets the current \ref cx_terminate_handler_t.
+ * @param ... The format followed by at most #CX_CONTEXT_ARGS_MAX arguments.
+ * The format must be a string literal (or otherwise have static storage
+ * duration).
  *
- * @param fn The new \ref cx_terminate_handler_t or NULL to use the default.
- * @return Returns the previous \ref cx_terminate_handler_t, if any.
+ * @note A `long double` argument is recorded as a `double`.  A pointer
+ * argument for `%p` must be cast to `void*`.
  *
- * @warning Terminate handler functions _must not_ return.
+ * @warning The string to which a `%s` argument points must still exist when
+ * the description is formatted, i.e., after the block has been exited if the
+ * exception is caught outside of it.
  *
- * @sa cx_get_terminate()
- * @sa cx_terminate()
+ * @warning Within a <code>%cx_context</code> block, you must _never_ `break`
+ * unless it's within your own loop or `switch`, `goto` outside the block, nor
+ * `return` from the function.  Nor may it contain #cx_co_yield().
+ *
+ * @sa cx_exception_context()
+ * @sa #cx_throwf()
  */
-cx_terminate_handler_t cx_set_terminate( cx_terminate_handler_t fn );
+#define cx_context(...)                                                 \
+  for ( cx_impl_context_scope_t cx_cs CX_IMPL_CONTEXT_CLEANUP,          \
+          *volatile cx_csp = cx_impl_context_push(                      \
+            &cx_cs, __FILE__, __LINE__,                                 \
+            CX_IMPL_NAME2( CX_IMPL_CONTEXT_ARGS_,                       \
+                           CX_IMPL_NARG( __VA_ARGS__ ) )( __VA_ARGS__ ) ); \
+        cx_csp != NULL; cx_csp = cx_impl_context_pop( cx_csp ) )
 
 /**
- * Sets the current \ref cx_xid_matcher_t.
+ * Begins an "escape point" block: if #cx_escape() is called with \a ID within
+ * the block, control is transferred directly to the end of the block.  This
+ * is useful for returning a result from a deep recursive search, for example:
+ *  ```c
+ *  #define ESC_FOUND 1
+ *
+ *  static void search( struct node const *node, int key ) {
+ *    if ( node == NULL )
+ *      return;
+ *    if ( node->key == key )
+ *      cx_escape( ESC_FOUND, node );
+ *    search( node->left, key );
+ *    search( node->right, key );
+ *  }
+ *
+ *  struct node const *found = NULL;
+ *  cx_escape_point( ESC_FOUND, found ) {
+ *    search( root, key );
+ *  }
+ *  ```
+ *
+ * @remarks Escaping is _not_ an exception: no exception is created, no
+ * #cx_catch block is tried, and the terminate handler is never called.
+ * However, the #cx_finally blocks of #cx_try blocks in between are executed in
+ * order.
+ *
+ * @param ID The escape ID.  It may be any value.  Escape points may be nested;
+ * #cx_escape() escapes to the innermost one having the same ID.
+ * @param RESULT An lvalue that is assigned the value passed to #cx_escape(),
+ * if called.
+ *
+ * @warning Any variables declared outside the <code>%cx_escape_point</code>
+ * block that are modified inside the block and used again outside the block
+ * _must_ be declared `volatile`, except \a RESULT.
+ *
+ * @warning Within a <code>%cx_escape_point</code> block, you must _never_
+ * `break` unless it's within your own loop or `switch`, `goto` outside the
+ * block, nor `return` from the function.
+ *
+ * @sa #cx_escape()
+ */
+#define cx_escape_point(ID,RESULT)                                    \
+  for ( cx_impl_try_block_t cx_eb CX_IMPL_TRY_CLEANUP,                \
+          *volatile cx_ebp =                                          \
+            cx_impl_escape_enter( &cx_eb, __FILE__, __LINE__, (ID) ); \
+        cx_ebp != NULL; cx_ebp = cx_impl_escape_exit( cx_ebp ) )      \
+    if ( CX_IMPL_SETJMP( cx_eb.env ) != 0 )                           \
+      (RESULT) = cx_impl_escape_value();                              \
+    else
+
+/**
+ * Escapes to the innermost enclosing #cx_escape_point having \a ID.
+ *
+ * @param ID The escape ID.
+ * @param VALUE The value to assign to the #cx_escape_point's result.
+ *
+ * @warning If there is no such #cx_escape_point, the program is aborted.
+ *
+ * @sa #cx_escape_point()
+ */
+#define cx_escape(ID,VALUE) \
+  cx_impl_escape( __FILE__, __LINE__, (ID), (void*)(VALUE) )
+
+/**
+ * Begins a "try" region of a stackless coroutine (e.g., one implemented via
+ * Duff's device or protothreads) that can remain open across yields.
+ *
+ * @remarks
+ * @parblock
+ * A #cx_try block can't remain open across a yield since its storage is on
+ * the stack.  Instead, a \ref cx_co_try_t stored in the coroutine's context
+ * is:
+ *
+ *  + Begun via <code>%cx_co_try</code>.
+ *  + Unlinked from the thread's chain of "try" blocks via cx_co_yield() just
+ *    before each yield.
+ *  + Relinked via #cx_co_resume() on each resume.
+ *  + Ended via cx_co_try_end().
+ *
+ * Both <code>%cx_co_try</code> and #cx_co_resume() are followed by a statement
+ * that's executed when an exception is thrown to the frame, typically a
+ * `goto` to the coroutine's handlers that call cx_co_catch().  For example:
+ *  ```c
+ *  struct conn {
+ *    unsigned    line;                 // resume point
+ *    cx_co_try_t tf;
+ *    // ...
+ *  };
+ *
+ *  bool conn_step( struct conn *c ) {  // returns true when done
+ *    cx_co_resume( &c->tf ) goto caught;
+ *    switch ( c->line ) {
+ *      case 0:
+ *        cx_co_try( &c->tf ) goto caught;
+ *        send_request( c );            // may throw
+ *        c->line = 1;
+ *        cx_co_yield( &c->tf );
+ *        return false;
+ *      case 1:
+ *        read_response( c );           // may throw
+ *        cx_co_try_end( &c->tf );
+ *    } // switch
+ *    return true;
+ *
+ *  caught:
+ *    if ( cx_co_catch( &c->tf, EX_IO_ERROR ) )
+ *      log_error( c );
+ *    cx_co_try_end( &c->tf );          // rethrows if not caught
+ *    return true;
+ *  }
+ *  ```
+ * @endparblock
+ *
+ * @param F A pointer to the \ref cx_co_try_t.
+ *
+ * @note Since the coroutine's state lives in its context, its variables need
+ * not be declared `volatile`.
+ *
+ * @warning The current exception is _not_ preserved across a yield.
+ *
+ * @warning A #cx_escape() through a coroutine's "try" region abandons it.
+ *
+ * @sa cx_co_catch()
+ * @sa #cx_co_resume()
+ * @sa cx_co_try_end()
+ * @sa cx_co_yield()
+ */
+#define cx_co_try(F)                                          \
+  if ( cx_impl_co_try_begin( (F), __FILE__, __LINE__ ) )      \
+    if ( CX_IMPL_CO_SETJMP( (F)->tb.env ) != 0 )
+
+/**
+ * Resumes a "try" region of a stackless coroutine begun by #cx_co_try(), if
+ * any: relinks \a F into the thread's chain of "try" blocks so exceptions
+ * thrown after resuming reach the coroutine's own handlers.  If \a F isn't
+ * begun, does nothing.
+ *
+ * @remarks It must be called at the start of every resume before any code
+ * that may throw.
+ *
+ * @param F A pointer to the \ref cx_co_try_t.
+ *
+ * @sa #cx_co_try()
+ */
+#define cx_co_resume(F)                                       \
+  if ( cx_impl_co_try_relink( (F) ) )                         \
+    if ( CX_IMPL_CO_SETJMP( (F)->tb.env ) != 0 )
+
+/**
+ * Catches the exception thrown to the coroutine "try" frame \a f, if any.
+ *
+ * @param f A pointer to the \ref cx_co_try_t.
+ * @param xid The exception ID to catch.  If #CX_XID_ANY, it is always caught.
+ * @return Returns `true` only if \a xid was caught.
+ *
+ * @sa #cx_co_try()
+ */
+bool cx_co_catch( cx_co_try_t *f, int xid );
+
+/**
+ * Ends the coroutine "try" region \a f.  If an exception was thrown to it
+ * that wasn't caught via cx_co_catch(), rethrows it.
+ *
+ * @param f A pointer to the \ref cx_co_try_t.  It may be begun again.
+ *
+ * @sa #cx_co_try()
+ */
+void cx_co_try_end( cx_co_try_t *f );
+
+/**
+ * Unlinks the coroutine "try" frame \a f, if begun, from the thread's chain of
+ * "try" blocks.  It must be called just before a coroutine yields.
+ *
+ * @param f A pointer to the \ref cx_co_try_t.
+ *
+ * @sa #cx_co_resume()
+ * @sa #cx_co_try()
+ */
+void cx_co_yield( cx_co_try_t *f );
+
+/**
+ * Gets the current exception, if any.
+ *
+ * @return If an exception is in progress, returns a pointer to it; otherwise
+ * returns NULL.
+ *
+ * @sa cx_user_data()
+ */
+cx_exception_t* cx_current_exception( void );
+
+/**
+ * Gets the description of a #cx_context block that was active when \a cex
+ * was thrown formatting it.
+ *
+ * @param cex The \ref cx_exception to get the context of.  If NULL, returns
+ * NULL.
+ * @param i The index of the context where 0 is the innermost.
+ * @return Returns said description, truncated to #CX_MESSAGE_SIZE_MAX - 1
+ * characters, or NULL if \a i &ge; \ref cx_exception::n_contexts
+ * "n_contexts".  It's in the same thread-local buffer as used by
+ * cx_exception_message().
+ *
+ * @sa #cx_context
+ */
+char const* cx_exception_context( cx_exception_t const *cex, unsigned i );
+
+/**
+ * Gets the message of \a cex formatting it if necessary.
+ *
+ * @param cex The \ref cx_exception to get the message of.  If NULL, returns
+ * NULL.
+ * @return Returns said message, truncated to #CX_MESSAGE_SIZE_MAX - 1
+ * characters, or NULL if \a cex wasn't thrown by #cx_throwf().  It's in a
+ * thread-local buffer that's overwritten by the next call on the same thread.
+ *
+ * @sa #cx_throwf()
+ */
+char const* cx_exception_message( cx_exception_t const *cex );
+
+/**
+ * Captures the current exception, if any, so it can be rethrown later, even
+ * by another thread, via cx_rethrow_ptr().  For example:
+ *  ```c
+ *  void* worker( void *arg ) {
+ *    struct task *const task = arg;
+ *    cx_try {
+ *      // ...
+ *    }
+ *    cx_catch() {
+ *      task->error = cx_exception_ptr_capture();
+ *    }
+ *    return NULL;
+ *  }
+ *
+ *  // ...
+ *  pthread_join( thread, NULL );
+ *  if ( task.error != NULL )
+ *    cx_rethrow_ptr( task.error );
+ *  ```
+ *
+ * @remarks Captures are allocated from a per-thread pool so they don't
+ * ordinarily require calling `malloc()`.
+ *
+ * @return If an exception is in progress, returns a new reference to a copy
+ * of it that must eventually be passed to either cx_exception_ptr_release()
+ * or cx_rethrow_ptr(); otherwise returns NULL.
+ *
+ * @sa cx_exception_ptr_copy()
+ * @sa cx_exception_ptr_exception()
+ * @sa cx_exception_ptr_release()
+ * @sa cx_rethrow_ptr()
+ */
+cx_exception_ptr_t* cx_exception_ptr_capture( void );
+
+/**
+ * Adds a reference to \a xp.
+ *
+ * @param xp The \ref cx_exception_ptr_t to add a reference to.
+ * @return Returns \a xp.
+ *
+ * @sa cx_exception_ptr_release()
+ */
+cx_exception_ptr_t* cx_exception_ptr_copy( cx_exception_ptr_t *xp );
+
+/**
+ * Gets the exception of \a xp.
+ *
+ * @param xp The \ref cx_exception_ptr_t to get the exception of.
+ * @return Returns a pointer to said exception that is valid as long as \a xp
+ * is.
+ */
+cx_exception_t const* cx_exception_ptr_exception( cx_exception_ptr_t const *xp );
+
+/**
+ * Releases a reference to \a xp: if it was the last reference, \a xp is
+ * returned to the pool of the thread that captured it.
+ *
+ * @param xp The \ref cx_exception_ptr_t to release.  If NULL, does nothing.
+ *
+ * @note It may be called by any thread.
+ *
+ * @sa cx_exception_ptr_copy()
+ */
+void cx_exception_ptr_release( cx_exception_ptr_t *xp );
+
+/**
+ * Gets all throw sites: the descriptors are placed into the `cx_sites` linker
+ * section, so they can be enumerated without any registration at run-time.
+ *
+ * @param n_sites A pointer to receive the number of sites.
+ * @return Returns a pointer to the first site or NULL if none.  The sites
+ * are those within the executable (or shared object) containing C Exception.
+ *
+ * @note Sites can be enumerated only on ELF platforms; elsewhere, this always
+ * returns NULL.
+ *
+ * @sa cx_site_id()
+ */
+cx_site_t const* cx_get_sites( size_t *n_sites );
+
+/**
+ * Gets the current \ref cx_terminate_handler_t, if any.
+ *
+ * @return Returns said handler or NULL if none.
+ *
+ * @sa cx_set_terminate()
+ * @sa cx_terminate()
+ */
+cx_terminate_handler_t cx_get_terminate( void );
+
+/**
+ * Gets the current per-thread \ref cx_terminate_handler_t, if any.
+ *
+ * @return Returns said handler or NULL if none.
+ *
+ * @sa cx_set_thread_terminate()
+ */
+cx_terminate_handler_t cx_get_thread_terminate( void );
+
+/**
+ * Gets the current per-thread \ref cx_xid_matcher_t, if any.
+ *
+ * @return Returns said function or NULL if none.
+ *
+ * @sa cx_set_thread_xid_matcher()
+ */
+cx_xid_matcher_t cx_get_thread_xid_matcher( void );
+
+/**
+ * Gets the current \ref cx_xid_matcher_t, if any.
+ *
+ * @return Returns said function or NULL if none.
+ *
+ * @sa cx_set_xid_matcher()
+ */
+cx_xid_matcher_t cx_get_xid_matcher( void );
+
+/**
+ * Calls \a fn within a "try" block that catches any exception.
+ *
+ * @remarks
+ * @parblock
+ * Unlike a #cx_try block, \a fn is an ordinary function, so variables it
+ * modifies need _not_ be declared `volatile`.  This allows the compiler to
+ * keep them in registers, e.g., for a loop:
+ *  ```c
+ *  struct parse_ctx { char const *s; size_t n; };
+ *
+ *  static void parse( void *p ) {
+ *    struct parse_ctx *const ctx = p;
+ *    char const *s = ctx->s;           // not volatile
+ *    for ( size_t n = ctx->n; n > 0; --n, ++s ) {
+ *      // ...
+ *      cx_throw( EX_SYNTAX_ERROR );
+ *    }
+ *  }
+ *
+ *  cx_exception_t cex;
+ *  if ( cx_invoke( &parse, &ctx, &cex ) )
+ *    fprintf( stderr, "%s:%d: error\n",
+ *             cx_exception_file( &cex ), cx_exception_line( &cex ) );
+ *  ```
+ * @endparblock
+ *
+ * @param fn The function to call.
+ * @param ctx The context pointer to pass to \a fn.
+ * @param cex A pointer to a cx_exception to receive a copy of the exception
+ * thrown, if any; may be NULL.  Since it outlives the exception, its \ref
+ * cx_exception::cause "cause" is always NULL.
+ * @return Returns `true` only if an exception was thrown by \a fn.
+ *
+ * @sa #cx_try
+ */
+bool cx_invoke( cx_invoke_fn_t fn, void *ctx, cx_exception_t *cex );
+
+/**
+ * Gets the #CX_PAYLOAD_DOUBLE payload of \a cex.
+ *
+ * @param cex The \ref cx_exception to get the payload of.  If NULL, returns
+ * 0.
+ * @return Returns said payload or 0 if \a cex has no #CX_PAYLOAD_DOUBLE
+ * payload.
+ *
+ * @sa #cx_throw_value()
+ */
+double cx_payload_double( cx_exception_t const *cex );
+
+/**
+ * Gets the #CX_PAYLOAD_INT payload of \a cex.
+ *
+ * @param cex The \ref cx_exception to get the payload of.  If NULL, returns
+ * 0.
+ * @return Returns said payload or 0 if \a cex has no #CX_PAYLOAD_INT payload.
+ *
+ * @sa #cx_throw_value()
+ */
+long long cx_payload_int( cx_exception_t const *cex );
+
+/**
+ * Gets a pointer to the #CX_PAYLOAD_STRUCT payload of \a cex.
+ *
+ * @param cex The \ref cx_exception to get the payload of.  If NULL, returns
+ * NULL.
+ * @return Returns a pointer to said payload, suitably aligned for any type,
+ * that is valid as long as \a cex is, or NULL if \a cex has no
+ * #CX_PAYLOAD_STRUCT payload.
+ *
+ * @sa #cx_throw_value()
+ */
+void const* cx_payload_ptr( cx_exception_t const *cex );
+
+/**
+ * Gets the #CX_PAYLOAD_STRING payload of \a cex.
+ *
+ * @param cex The \ref cx_exception to get the payload of.  If NULL, returns
+ * NULL.
+ * @return Returns said payload that is valid as long as \a cex is or NULL if
+ * \a cex has no #CX_PAYLOAD_STRING payload.
+ *
+ * @sa #cx_throw_value()
+ */
+char const* cx_payload_string( cx_exception_t const *cex );
+
+/**
+ * Rethrows the exception of \a xp, including its original \ref
+ * cx_exception::thrown_site "thrown_site" and \ref cx_exception::user_data
+ * "user_data", then releases the reference to \a xp.
+ *
+ * @param xp The \ref cx_exception_ptr_t to rethrow.
+ *
+ * @sa cx_exception_ptr_capture()
+ */
+_Noreturn
+void cx_rethrow_ptr( cx_exception_ptr_t *xp );
+
+/**
+ * Sets the current per-thread \ref cx_terminate_handler_t that, if set,
+ * takes precedence over the one set by cx_set_terminate().
+ *
+ * @param fn The new \ref cx_terminate_handler_t or NULL for none.
+ * @return Returns the previous per-thread \ref cx_terminate_handler_t, if any.
+ *
+ * @warning Terminate handler functions _must not_ return.
+ *
+ * @sa cx_get_thread_terminate()
+ * @sa cx_set_terminate()
+ */
+cx_terminate_handler_t cx_set_thread_terminate( cx_terminate_handler_t fn );
+
+/**
+ * Sets the current per-thread \ref cx_xid_matcher_t that, if set, takes
+ * precedence over the one set by cx_set_xid_matcher().
+ *
+ * @param fn The new \ref cx_xid_matcher_t or NULL for none.
+ * @return Returns the previous per-thread \ref cx_xid_matcher_t, if any.
+ *
+ * @sa cx_get_thread_xid_matcher()
+ * @sa cx_set_xid_matcher()
+ * @sa #cx_try_with_matcher()
+ */
+cx_xid_matcher_t cx_set_thread_xid_matcher( cx_xid_matcher_t fn );
+
+/**
+ * Sets the current \ref cx_terminate_handler_t.
+ *
+ * @param fn The new \ref cx_terminate_handler_t or NULL to use the default.
+ * @return Returns the previous \ref cx_terminate_handler_t, if any.
+ *
+ * @note It's set atomically for all threads.
+ *
+ * @warning Terminate handler functions _must not_ return.
+ *
+ * @sa cx_get_terminate()
+ * @sa cx_terminate()
+ */
+cx_terminate_handler_t cx_set_terminate( cx_terminate_handler_t fn );
+
+/**
+ * Sets the current \ref cx_xid_matcher_t.
  *
  * @param fn The new \ref cx_xid_matcher_t or NULL to use the default.
  * @return Returns the previous \ref cx_xid_matcher_t, if any.
  *
+ * @note It's set atomically for all threads.  However, it's not used by
+ * #cx_catch blocks compiled with #CX_XID_MATCHER defined.
+ *
  * @sa cx_get_xid_matcher()
  */
 cx_xid_matcher_t cx_set_xid_matcher( cx_xid_matcher_t fn );
 
+/**
+ * Gets the ID of a throw site: IDs are dense, so they can index an array
+ * having as many elements as cx_get_sites() returns, e.g., to count the
+ * exceptions thrown from each:
+ *  ```c
+ *  size_t n_sites;
+ *  cx_get_sites( &n_sites );
+ *  unsigned *const counts = calloc( n_sites, sizeof *counts );
+ *  // ...
+ *  cx_catch() {
+ *    ++counts[ cx_site_id( cx_current_exception()->thrown_site ) ];
+ *  }
+ *  ```
+ *
+ * @param site The \ref cx_site to get the ID of.
+ * @return Returns said ID or `SIZE_MAX` if \a site isn't among those returned
+ * by cx_get_sites().
+ *
+ * @sa cx_get_sites()
+ */
+size_t cx_site_id( cx_site_t const *site );
+
+/**
+ * Switches the state of C Exception, i.e., the chain of #cx_try blocks and
+ * the current exception, from one fiber to another.
+ *
+ * @remarks
+ * @parblock
+ * The state is per thread.  When fibers are multiplexed over a thread, a fiber
+ * that switches to another from within a #cx_try block would otherwise
+ * corrupt the other fiber's chain of #cx_try blocks.  Hence, a fiber scheduler
+ * must call this whenever it switches fibers on a thread.  For example:
+ *  ```c
+ *  void fiber_switch( struct fiber *from, struct fiber *to ) {
+ *    cx_state_swap( &from->cx_state, &to->cx_state );
+ *    swapcontext( &from->ctx, &to->ctx );
+ *  }
+ *  ```
+ * Each new fiber's state must be initialized with #CX_FIBER_STATE_INIT.
+ *
+ * It costs only a few loads and stores: each fiber's current exception stays
+ * in its own \ref cx_fiber_state and only pointers to it are exchanged.
+ * @endparblock
+ *
+ * @param from The \ref cx_fiber_state to save the current state into.
+ * @param to The \ref cx_fiber_state to restore the current state from.  It may
+ * be the same as \a from.
+ */
+void cx_state_swap( cx_fiber_state_t *from, cx_fiber_state_t *to );
+
 /**
  * Gets the user-data, if any, associated with the current exception, if any.
  *
@@ -471,58 +1603,412 @@ inline void* cx_user_data( void ) {
   return cex != NULL ? cex->user_data : NULL;
 }
 
+/**
+ * Gets the file whence \a cex was thrown.
+ *
+ * @param cex The \ref cx_exception to get the file of.  If NULL, returns NULL.
+ * @return Returns said file or NULL.
+ *
+ * @sa cx_exception::thrown_site
+ * @sa cx_exception_line()
+ */
+inline char const* cx_exception_file( cx_exception_t const *cex ) {
+  return cex != NULL && cex->thrown_site != NULL ?
+    cex->thrown_site->file : NULL;
+}
+
+/**
+ * Gets the line number within cx_exception_file() whence \a cex was thrown.
+ *
+ * @param cex The \ref cx_exception to get the line number of.  If NULL,
+ * returns 0.
+ * @return Returns said line number or 0.
+ *
+ * @sa cx_exception::thrown_site
+ * @sa cx_exception_file()
+ */
+inline int cx_exception_line( cx_exception_t const *cex ) {
+  return cex != NULL && cex->thrown_site != NULL ?
+    cex->thrown_site->line : 0;
+}
+
 /** @} */
 
-////////// implementation /////////////////////////////////////////////////////
+////////// implementation /////////////////////////////////////////////////////
+
+/**
+ * @defgroup c-exception-implementation-group Implementation API
+ * Declares types, macros, and functions for the implementation.
+ *
+ * @note Everything in the implementation API starts with either `cx_impl_` or
+ * `CX_IMPL_`.
+ *
+ * @{
+ */
+
+/// @cond DOXYGEN_IGNORE
+
+// See <https://stackoverflow.com/a/11742317/99089>
+
+/**
+ * The maximum number of arguments that can be counted by CX_IMPL_NARG().
+ */
+#define CX_IMPL_NARG_MAX          32
+
+#define CX_IMPL_ARG_N(                                \
+   _1, _2, _3, _4, _5, _6, _7, _8, _9,_10,_11,_12,_13,_14,_15,_16, \
+  _17,_18,_19,_20,_21,_22,_23,_24,_25,_26,_27,_28,_29,_30,_31,_32, \
+  N,...) N
+#define CX_IMPL_COMMA(...)        ,
+#define CX_IMPL_REV_SEQ_N                                         \
+  32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, \
+  16, 15, 14, 13, 12, 11, 10,  9,  8,  7,  6,  5,  4,  3,  2,  1, 0
+
+#define CX_IMPL_HAS_COMMA_N                                       \
+   1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1, \
+   1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  0, 0
+#define CX_IMPL_HAS_COMMA(...) \
+  CX_IMPL_NARG_( __VA_ARGS__, CX_IMPL_HAS_COMMA_N )
+
+#define CX_IMPL_NARG_(...)        CX_IMPL_ARG_N( __VA_ARGS__ )
+#define CX_IMPL_NARG(...)                               \
+  CX_IMPL_NARG_HELPER1(                                 \
+    CX_IMPL_HAS_COMMA( __VA_ARGS__ ),                   \
+    CX_IMPL_HAS_COMMA( CX_IMPL_COMMA __VA_ARGS__ () ),  \
+    CX_IMPL_NARG_( __VA_ARGS__, CX_IMPL_REV_SEQ_N ) )
+
+#define CX_IMPL_NARG_HELPER1(A,B,N)   CX_IMPL_NARG_HELPER2(A, B, N)
+#define CX_IMPL_NARG_HELPER2(A,B,N)   CX_IMPL_NARG_HELPER3_ ## A ## B(N)
+#define CX_IMPL_NARG_HELPER3_01(N)    0
+#define CX_IMPL_NARG_HELPER3_00(N)    1
+#define CX_IMPL_NARG_HELPER3_11(N)    N
+
+#define CX_IMPL_NAME2(A,B)        CX_IMPL_NAME2_HELPER(A,B)
+#define CX_IMPL_NAME2_HELPER(A,B) A##B
+
+#define CX_IMPL_DEF_ARGS(PREFIX,...) \
+  CX_IMPL_NAME2(PREFIX, CX_IMPL_NARG(__VA_ARGS__))(__VA_ARGS__)
+
+#define CX_IMPL_MANY_SEQ_N                                        \
+   N,  N,  N,  N,  N,  N,  N,  N,  N,  N,  N,  N,  N,  N,  N,  N, \
+   N,  N,  N,  N,  N,  N,  N,  N,  N,  N,  N,  N,  N,  N,  N,  1, 0
+
+/**
+ * Like CX_IMPL_NARG(), but expands to `0`, `1`, or `N` for more than 1.
+ */
+#define CX_IMPL_NARG_01N(...)                           \
+  CX_IMPL_NARG_HELPER1(                                 \
+    CX_IMPL_HAS_COMMA( __VA_ARGS__ ),                   \
+    CX_IMPL_HAS_COMMA( CX_IMPL_COMMA __VA_ARGS__ () ),  \
+    CX_IMPL_NARG_( __VA_ARGS__, CX_IMPL_MANY_SEQ_N ) )
+
+#define CX_IMPL_DEF_ARGS_01N(PREFIX,...) \
+  CX_IMPL_NAME2(PREFIX, CX_IMPL_NARG_01N(__VA_ARGS__))(__VA_ARGS__)
+
+#define CX_IMPL_CATCH_0()         CX_IMPL_CATCH_1( CX_XID_ANY )
+#ifdef CX_XID_MATCHER
+# define CX_IMPL_CATCH_FN         cx_impl_catch_inline
+# define CX_IMPL_CATCH_ANY_OF_FN  cx_impl_catch_any_of_inline
+#else
+# define CX_IMPL_CATCH_FN         cx_impl_catch
+# define CX_IMPL_CATCH_ANY_OF_FN  cx_impl_catch_any_of
+#endif /* CX_XID_MATCHER */
+
+#define CX_IMPL_CATCH_1(XID) \
+  else if ( CX_IMPL_CATCH_FN( (XID), &cx_tb ) )
+#define CX_IMPL_CATCH_N(...)                                        \
+  else if ( CX_IMPL_CATCH_ANY_OF_FN( (int const[]){ __VA_ARGS__ },  \
+                                     CX_IMPL_NARG( __VA_ARGS__ ),   \
+                                     &cx_tb ) )
+
+#if CX_CANCEL_FINALLY
+# if !defined(__GNUC__)
+#   error "CX_CANCEL_FINALLY requires GCC or Clang."
+# endif
+# define CX_IMPL_SCOPE_CLEANUP \
+    __attribute__((cleanup(cx_impl_matcher_scope_cleanup)))
+# define CX_IMPL_CONTEXT_CLEANUP \
+    __attribute__((cleanup(cx_impl_context_cleanup)))
+#else
+# define CX_IMPL_SCOPE_CLEANUP    /* nothing */
+# define CX_IMPL_CONTEXT_CLEANUP  /* nothing */
+#endif /* CX_CANCEL_FINALLY */
+
+#if CX_CANCEL_FINALLY || CX_JMP_BACKEND == CX_JMP_BACKEND_UNWIND
+# define CX_IMPL_TRY_CLEANUP      __attribute__((cleanup(cx_impl_try_cleanup)))
+#else
+# define CX_IMPL_TRY_CLEANUP      /* nothing */
+#endif /* CX_CANCEL_FINALLY || CX_JMP_BACKEND == CX_JMP_BACKEND_UNWIND */
+
+#if CX_INLINE_FAST_PATH
+#define CX_IMPL_TRY_FOR(XIDS)                                       \
+  for ( cx_impl_try_block_t cx_tb CX_IMPL_TRY_CLEANUP, *const cx_tbp = \
+          cx_impl_try_enter( &cx_tb, __FILE__, __LINE__, (XIDS) );  \
+        cx_impl_try_condition_fast( cx_tbp ); )
+#else
+#define CX_IMPL_TRY_FOR(XIDS)                             \
+  for ( cx_impl_try_block_t cx_tb CX_IMPL_TRY_CLEANUP =   \
+          { .try_file = __FILE__, .try_line = __LINE__,   \
+            .catch_xids = (XIDS) };                       \
+        cx_impl_try_condition( &cx_tb ); )
+#endif /* CX_INLINE_FAST_PATH */
+
+#define CX_IMPL_TRY(XIDS)                       \
+  CX_IMPL_TRY_FOR( XIDS )                       \
+    if ( cx_tb.state != CX_IMPL_FINALLY )       \
+      if ( CX_IMPL_SETJMP( cx_tb.env ) == 0 )
+
+#define CX_IMPL_THROW_0() \
+  CX_IMPL_SITE_CALL( cx_impl_rethrow, cx_tb.thrown_xid )
+#define CX_IMPL_THROW_1(XID)      CX_IMPL_THROW_2( (XID), cx_user_data() )
+#define CX_IMPL_THROW_2(XID,DATA) \
+  CX_IMPL_SITE_CALL( cx_impl_throw, (XID), (void*)(DATA) )
+
+#define CX_IMPL_THROW_NESTED_1(XID) \
+  CX_IMPL_THROW_NESTED_2( (XID), NULL )
+#define CX_IMPL_THROW_NESTED_2(XID,DATA) \
+  CX_IMPL_SITE_CALL( cx_impl_throw_nested, (XID), (void*)(DATA) )
+
+//
+// A pointer to a static \ref cx_site for the current source location, if the
+// compiler supports it as an expression (GCC, Clang, or C23).  On ELF
+// platforms, it's placed into the `cx_sites` section so all of them are
+// contiguous and can be enumerated via the linker-generated `__start_cx_sites`
+// and `__stop_cx_sites` symbols.  Its alignment is explicit so the compiler
+// won't over-align it and leave gaps.
+//
+#if defined(__GNUC__)
+# ifdef __ELF__
+#   define CX_IMPL_SITE_SECTION                                   \
+      __attribute__((section("cx_sites"), used,                   \
+                     aligned(__alignof__(cx_site_t))))
+# else
+#   define CX_IMPL_SITE_SECTION   /* nothing */
+# endif /* __ELF__ */
+# define CX_IMPL_SITE()           __extension__ ({                  \
+    static cx_site_t const cx_site CX_IMPL_SITE_SECTION =           \
+      { .file = __FILE__, .func = __func__, .line = __LINE__ };     \
+    &cx_site; })
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 202311L
+# define CX_IMPL_SITE()                                            \
+    (&(static cx_site_t const){                                     \
+      .file = __FILE__, .func = __func__, .line = __LINE__ })
+#endif /* __GNUC__ */
+
+//
+// Calls FN with a pointer to the static \ref cx_site for the current source
+// location followed by the remaining arguments.  Where CX_IMPL_SITE() can't be
+// an expression, the site is a function-local static within a `do`-`while`,
+// so the call is then a statement rather than an expression.
+//
+#ifdef CX_IMPL_SITE
+# define CX_IMPL_SITE_CALL(FN,...)  FN( CX_IMPL_SITE(), __VA_ARGS__ )
+#else
+# define CX_IMPL_SITE_CALL(FN,...)                                  \
+    do {                                                            \
+      static cx_site_t const cx_site =                              \
+        { .file = __FILE__, .func = __func__, .line = __LINE__ };   \
+      FN( &cx_site, __VA_ARGS__ );                                  \
+    } while (0)
+#endif /* CX_IMPL_SITE */
+
+#if defined(__GNUC__)
+# define CX_IMPL_AUTO             __auto_type
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 202311L
+# define CX_IMPL_AUTO             auto
+#endif
+
+#if defined(__GNUC__)
+# define CX_IMPL_PRINTF_LIKE(FMT_IDX) \
+    __attribute__((format(printf, (FMT_IDX), (FMT_IDX) + 1)))
+#else
+# define CX_IMPL_PRINTF_LIKE(FMT_IDX) /* nothing */
+#endif /* __GNUC__ */
+
+//
+// The arguments of cx_impl_context_push() for a #cx_context having N - 1
+// arguments following the format.  The call to cx_impl_context_check() is
+// never evaluated: it's only so the compiler checks the arguments against the
+// format.
+//
+#define CX_IMPL_CONTEXT_ARGS_1(FMT) \
+  ((void)sizeof cx_impl_context_check( FMT ), (FMT)), 0, NULL
+#define CX_IMPL_CONTEXT_ARGS_2(FMT,A) \
+  ((void)sizeof cx_impl_context_check( FMT, A ), (FMT)), 1, \
+  (union cx_impl_format_arg const[]){ CX_IMPL_FORMAT_ARG( A ) }
+#define CX_IMPL_CONTEXT_ARGS_3(FMT,A,B) \
+  ((void)sizeof cx_impl_context_check( FMT, A, B ), (FMT)), 2, \
+  (union cx_impl_format_arg const[]){ CX_IMPL_FORMAT_ARG( A ),  \
+                                      CX_IMPL_FORMAT_ARG( B ) }
+#define CX_IMPL_CONTEXT_ARGS_4(FMT,A,B,C) \
+  ((void)sizeof cx_impl_context_check( FMT, A, B, C ), (FMT)), 3, \
+  (union cx_impl_format_arg const[]){ CX_IMPL_FORMAT_ARG( A ),  \
+                                      CX_IMPL_FORMAT_ARG( B ),  \
+                                      CX_IMPL_FORMAT_ARG( C ) }
+
+#define CX_IMPL_FORMAT_ARG(X)                         \
+  _Generic( (X),                                      \
+    float               : cx_impl_format_arg_d,       \
+    double              : cx_impl_format_arg_d,       \
+    long double         : cx_impl_format_arg_ld,      \
+    char*               : cx_impl_format_arg_p,       \
+    char const*         : cx_impl_format_arg_p,       \
+    void*               : cx_impl_format_arg_p,       \
+    void const*         : cx_impl_format_arg_p,       \
+    default             : cx_impl_format_arg_i        \
+  )( (X) )
+
+/**
+ * How cx_impl_throw_value() must interpret the bytes of a value.
+ */
+enum cx_impl_payload_kind {
+  CX_IMPL_PAYLOAD_SINT,                 ///< A signed integer.
+  CX_IMPL_PAYLOAD_UINT,                 ///< An unsigned integer.
+  CX_IMPL_PAYLOAD_FLOAT,                ///< A `float`.
+  CX_IMPL_PAYLOAD_DOUBLE,               ///< A `double`.
+  CX_IMPL_PAYLOAD_LDOUBLE,              ///< A `long double`.
+  CX_IMPL_PAYLOAD_STRING,               ///< A pointer to `char`.
+  CX_IMPL_PAYLOAD_STRUCT                ///< Anything else.
+};
+typedef enum cx_impl_payload_kind cx_impl_payload_kind_t;
+
+#define CX_IMPL_PAYLOAD_KIND(V)                     \
+  _Generic( (V),                                    \
+    _Bool               : CX_IMPL_PAYLOAD_UINT,     \
+    char                : (char)-1 < 0 ?            \
+                            CX_IMPL_PAYLOAD_SINT :  \
+                            CX_IMPL_PAYLOAD_UINT,   \
+    signed char         : CX_IMPL_PAYLOAD_SINT,     \
+    unsigned char       : CX_IMPL_PAYLOAD_UINT,     \
+    short               : CX_IMPL_PAYLOAD_SINT,     \
+    unsigned short      : CX_IMPL_PAYLOAD_UINT,     \
+    int                 : CX_IMPL_PAYLOAD_SINT,     \
+    unsigned            : CX_IMPL_PAYLOAD_UINT,     \
+    long                : CX_IMPL_PAYLOAD_SINT,     \
+    unsigned long       : CX_IMPL_PAYLOAD_UINT,     \
+    long long           : CX_IMPL_PAYLOAD_SINT,     \
+    unsigned long long  : CX_IMPL_PAYLOAD_UINT,     \
+    float               : CX_IMPL_PAYLOAD_FLOAT,    \
+    double              : CX_IMPL_PAYLOAD_DOUBLE,   \
+    long double         : CX_IMPL_PAYLOAD_LDOUBLE,  \
+    char*               : CX_IMPL_PAYLOAD_STRING,   \
+    char const*         : CX_IMPL_PAYLOAD_STRING,   \
+    default             : CX_IMPL_PAYLOAD_STRUCT )
+
+#if   CX_JMP_BACKEND == CX_JMP_BACKEND_LIBC
+typedef jmp_buf                   cx_impl_jmp_buf_t;
+# define CX_IMPL_SETJMP(ENV)      setjmp( (ENV) )
+# define CX_IMPL_LONGJMP(ENV)     longjmp( (ENV), 1 )
+#elif CX_JMP_BACKEND == CX_JMP_BACKEND_BUILTIN
+# if !defined(__GNUC__)
+#   error "CX_JMP_BACKEND_BUILTIN requires GCC or Clang."
+# endif
+typedef void                     *cx_impl_jmp_buf_t[5];
+# define CX_IMPL_SETJMP(ENV)      __builtin_setjmp( (ENV) )
+# define CX_IMPL_LONGJMP(ENV)     __builtin_longjmp( (ENV), 1 )
+#elif CX_JMP_BACKEND == CX_JMP_BACKEND_SIGSETJMP
+typedef sigjmp_buf                cx_impl_jmp_buf_t;
+# define CX_IMPL_SETJMP(ENV)      sigsetjmp( (ENV), 0 )
+# define CX_IMPL_LONGJMP(ENV)     siglongjmp( (ENV), 1 )
+#elif CX_JMP_BACKEND == CX_JMP_BACKEND_X86_64 || \
+      CX_JMP_BACKEND == CX_JMP_BACKEND_UNWIND
+# if !(defined(__x86_64__) && defined(__linux__) && \
+       defined(__GNUC__) && !defined(__clang__))
+#   if CX_JMP_BACKEND == CX_JMP_BACKEND_X86_64
+#     error "CX_JMP_BACKEND_X86_64 requires GCC on x86-64 Linux."
+#   else
+#     error "CX_JMP_BACKEND_UNWIND requires GCC on x86-64 Linux."
+#   endif
+# endif
+# if CX_JMP_BACKEND == CX_JMP_BACKEND_UNWIND && !defined(__EXCEPTIONS)
+#   error "CX_JMP_BACKEND_UNWIND requires -fexceptions."
+# endif
+/**
+ * The minimal execution context saved by cx_impl_ctx_save().
+ */
+struct cx_impl_ctx {
+  void *rbp;                            ///< Frame pointer.
+  void *rsp;                            ///< Stack pointer.
+  void *rip;                            ///< Resume address.
+};
+typedef struct cx_impl_ctx        cx_impl_jmp_buf_t[1];
+
+/**
+ * Saves the minimal execution context.
+ *
+ * @param ctx A pointer to the \ref cx_impl_ctx to save into.
+ * @return Returns 0 when called directly or 1 when returning via
+ * cx_impl_ctx_restore().
+ *
+ * @note This must be called only via #CX_IMPL_SETJMP() that forces the
+ * calling function to save all other callee-saved registers itself.
+ */
+__attribute__((returns_twice))
+int cx_impl_ctx_save( struct cx_impl_ctx *ctx );
+
+/**
+ * Restores the minimal execution context saved by cx_impl_ctx_save() that
+ * then returns 1.
+ *
+ * @param ctx A pointer to the \ref cx_impl_ctx to restore from.
+ */
+_Noreturn
+void cx_impl_ctx_restore( struct cx_impl_ctx const *ctx );
 
+# if CX_JMP_BACKEND == CX_JMP_BACKEND_X86_64
+#   define CX_IMPL_SETJMP(ENV)    __extension__ ({                \
+    __asm__ volatile ( "" ::: "rbx", "r12", "r13", "r14", "r15" ); \
+    cx_impl_ctx_save( (ENV) ); })
+# else
 /**
- * @defgroup c-exception-implementation-group Implementation API
- * Declares types, macros, and functions for the implementation.
+ * Saves only the resume address of the minimal execution context: its frame
+ * pointer and stack pointer are instead those the unwinder restores when it
+ * unwinds back to the calling function.
  *
- * @note Everything in the implementation API starts with either `cx_impl_` or
- * `CX_IMPL_`.
+ * @param ctx A pointer to the \ref cx_impl_ctx to save into.
+ * @return Returns 0 when called directly or 1 when returning via
+ * cx_impl_ctx_land().
  *
- * @{
+ * @note This must be called only via #CX_IMPL_SETJMP() that forces the
+ * calling function to save all other callee-saved registers itself.
  */
+__attribute__((returns_twice))
+int cx_impl_ctx_mark( struct cx_impl_ctx *ctx );
 
-/// @cond DOXYGEN_IGNORE
-
-// See <https://stackoverflow.com/a/11742317/99089>
-
-#define CX_IMPL_ARG_N(_1,_2,_3,_4,_5,_6,_7,_8,_9,N,...) N
-#define CX_IMPL_COMMA(...)        ,
-#define CX_IMPL_REV_SEQ_N         9, 8, 7, 6, 5, 4, 3, 2, 1, 0
-
-#define CX_IMPL_HAS_COMMA_N       1, 1, 1, 1, 1, 1, 1, 1, 0, 0
-#define CX_IMPL_HAS_COMMA(...) \
-  CX_IMPL_NARG_( __VA_ARGS__, CX_IMPL_HAS_COMMA_N )
-
-#define CX_IMPL_NARG_(...)        CX_IMPL_ARG_N( __VA_ARGS__ )
-#define CX_IMPL_NARG(...)                               \
-  CX_IMPL_NARG_HELPER1(                                 \
-    CX_IMPL_HAS_COMMA( __VA_ARGS__ ),                   \
-    CX_IMPL_HAS_COMMA( CX_IMPL_COMMA __VA_ARGS__ () ),  \
-    CX_IMPL_NARG_( __VA_ARGS__, CX_IMPL_REV_SEQ_N ) )
-
-#define CX_IMPL_NARG_HELPER1(A,B,N)   CX_IMPL_NARG_HELPER2(A, B, N)
-#define CX_IMPL_NARG_HELPER2(A,B,N)   CX_IMPL_NARG_HELPER3_ ## A ## B(N)
-#define CX_IMPL_NARG_HELPER3_01(N)    0
-#define CX_IMPL_NARG_HELPER3_00(N)    1
-#define CX_IMPL_NARG_HELPER3_11(N)    N
-
-#define CX_IMPL_NAME2(A,B)        CX_IMPL_NAME2_HELPER(A,B)
-#define CX_IMPL_NAME2_HELPER(A,B) A##B
-
-#define CX_IMPL_DEF_ARGS(PREFIX,...) \
-  CX_IMPL_NAME2(PREFIX, CX_IMPL_NARG(__VA_ARGS__))(__VA_ARGS__)
+/**
+ * Resumes the execution context marked by cx_impl_ctx_mark() that then
+ * returns 1.
+ *
+ * @param ctx A pointer to the \ref cx_impl_ctx to resume.
+ *
+ * @note This must be called only from the cleanup of the same function that
+ * called cx_impl_ctx_mark() while the unwinder is running it, i.e., when its
+ * stack pointer is that function's own.
+ */
+_Noreturn
+void cx_impl_ctx_land( struct cx_impl_ctx const *ctx );
 
-#define CX_IMPL_CATCH_0()         CX_IMPL_CATCH_1( CX_XID_ANY )
-#define CX_IMPL_CATCH_1(XID)      else if ( cx_impl_catch( (XID), &cx_tb ) )
+#   define CX_IMPL_SETJMP(ENV)    __extension__ ({                \
+    __asm__ volatile ( "" ::: "rbx", "r12", "r13", "r14", "r15" ); \
+    cx_impl_ctx_mark( (ENV) ); })
+// A stackless coroutine's "try" region isn't in a local variable, hence has no
+// cleanup to resume it from, so it saves the full execution context.
+#   define CX_IMPL_CO_SETJMP(ENV) __extension__ ({                \
+    __asm__ volatile ( "" ::: "rbx", "r12", "r13", "r14", "r15" ); \
+    cx_impl_ctx_save( (ENV) ); })
+#   define CX_IMPL_LAND(ENV)      cx_impl_ctx_land( (ENV) )
+# endif /* CX_JMP_BACKEND == CX_JMP_BACKEND_X86_64 */
+# define CX_IMPL_LONGJMP(ENV)     cx_impl_ctx_restore( (ENV) )
+#else
+# error "CX_JMP_BACKEND must be one of CX_JMP_BACKEND_{LIBC,BUILTIN,SIGSETJMP,X86_64,UNWIND}."
+#endif /* CX_JMP_BACKEND */
 
-#define CX_IMPL_THROW_0()         CX_IMPL_THROW_1( cx_tb.thrown_xid )
-#define CX_IMPL_THROW_1(XID)      CX_IMPL_THROW_2( (XID), cx_user_data() )
-#define CX_IMPL_THROW_2(XID,DATA) \
-  cx_impl_throw( __FILE__, __LINE__, (XID), (void*)(DATA) )
+#ifndef CX_IMPL_CO_SETJMP
+# define CX_IMPL_CO_SETJMP(ENV)   CX_IMPL_SETJMP( ENV )
+#endif /* CX_IMPL_CO_SETJMP */
+#ifndef CX_IMPL_LAND
+# define CX_IMPL_LAND(ENV)        CX_IMPL_LONGJMP( ENV )
+#endif /* CX_IMPL_LAND */
 
 /// @endcond
 
@@ -534,7 +2020,11 @@ enum cx_impl_state {
   CX_IMPL_TRY,                          ///< No exception thrown.
   CX_IMPL_THROWN,                       ///< Exception thrown, but uncaught.
   CX_IMPL_CAUGHT,                       ///< Exception caught.
-  CX_IMPL_FINALLY                       ///< Running #cx_finally code, if any.
+  CX_IMPL_FINALLY,                      ///< Running #cx_finally code, if any.
+  CX_IMPL_NOEXCEPT,                     ///< A #cx_noexcept barrier.
+  CX_IMPL_ESCAPE,                       ///< A #cx_escape_point.
+  CX_IMPL_SCOPE,                        ///< A #cx_try_with_matcher scope.
+  CX_IMPL_CONTEXT                       ///< A #cx_context scope.
 };
 typedef enum cx_impl_state cx_impl_state_t;
 
@@ -544,19 +2034,98 @@ typedef struct cx_impl_try_block cx_impl_try_block_t;
  * Internal state of #cx_try block.
  */
 struct cx_impl_try_block {
-  char const           *try_file;       ///< File containing the #cx_try.
-  int                   try_line;       ///< Line within \ref try_file.
-  jmp_buf               env;            ///< Jump buffer.
-  cx_impl_try_block_t  *parent;         ///< Enclosing parent #cx_try, if any.
+  // Fields accessed on every state transition go first.
   cx_impl_state_t       state;          ///< Current state.
   int                   thrown_xid;     ///< Thrown exception ID, if any.
+  cx_impl_try_block_t  *parent;         ///< Enclosing parent #cx_try, if any.
+  cx_impl_jmp_buf_t     env;            ///< Jump buffer.
   int                   caught_xid;     ///< Caught exception ID, if any.
+  int                   try_line;       ///< Line within \ref try_file.
+
+  /// Exception IDs declared by #cx_try_catching, if any: the first element is
+  /// the number of exception IDs, the second is non-zero only if the block
+  /// has a #cx_finally block, then the exception IDs follow.  If NULL, the
+  /// block is never skipped when searching for a handler.
+  int const            *catch_xids;
+
+  char const           *try_file;       ///< File containing the #cx_try.
 #ifndef NDEBUG
   /// Prevents infinite loops.
   unsigned              try_condition_calls;
 #endif /* NDEBUG */
 };
 
+/**
+ * A #cx_try_with_matcher scope.
+ */
+struct cx_impl_matcher_scope {
+  cx_impl_try_block_t             node;     ///< Must be first.
+  cx_xid_matcher_t                matcher;  ///< Exception matcher, if any.
+  struct cx_impl_matcher_scope   *prev;     ///< Enclosing scope, if any.
+};
+typedef struct cx_impl_matcher_scope cx_impl_matcher_scope_t;
+
+/**
+ * A #cx_context scope.
+ */
+struct cx_impl_context_scope {
+  cx_impl_try_block_t           node;     ///< Must be first.
+  struct cx_impl_context        context;  ///< Format and arguments.
+  struct cx_impl_context_scope *outer;    ///< Previous innermost scope.
+};
+typedef struct cx_impl_context_scope cx_impl_context_scope_t;
+
+/**
+ * A "try" frame of a stackless coroutine.
+ *
+ * @sa #cx_co_try()
+ */
+struct cx_co_try {
+  cx_impl_try_block_t tb;               ///< The frame itself.
+};
+
+/**
+ * Macro that expands into whatever the platform uses to specify that a
+ * variable is thread-local.
+ */
+#if   defined(__cplusplus)
+# define CX_IMPL_THREAD_LOCAL     thread_local
+#elif __STDC_VERSION__ >= 202311L
+# define CX_IMPL_THREAD_LOCAL     thread_local
+#elif __STDC_VERSION__ >= 201112L
+# define CX_IMPL_THREAD_LOCAL     _Thread_local
+#elif defined( _MSC_VER )
+# define CX_IMPL_THREAD_LOCAL     __declspec( thread )
+#elif defined( __GNUC__ )
+# define CX_IMPL_THREAD_LOCAL     __thread
+#else
+# error "Don't know how to declare thread-local variables on this platform."
+#endif
+
+/**
+ * Linked list of open "try" blocks.
+ */
+extern CX_IMPL_THREAD_LOCAL cx_impl_try_block_t *cx_impl_try_block_head;
+
+/**
+ * The innermost #cx_context scope, if any.  It's NULL only if there are no
+ * #cx_context scopes in \ref cx_impl_try_block_head; otherwise, it may be
+ * stale (never dereferenced) if a throw skipped scopes, until the next throw.
+ */
+extern CX_IMPL_THREAD_LOCAL cx_impl_context_scope_t *cx_impl_context_top;
+
+/**
+ * Non-zero only while this library is updating its per-thread state, i.e.,
+ * while a signal handler must not throw.
+ */
+extern CX_IMPL_THREAD_LOCAL sig_atomic_t volatile cx_impl_busy;
+
+/**
+ * The signal, if any, whose handler deferred throwing because \ref
+ * cx_impl_busy was set: it's raised again once \ref cx_impl_busy is cleared.
+ */
+extern CX_IMPL_THREAD_LOCAL sig_atomic_t volatile cx_impl_busy_deferred_sig;
+
 /**
  * Catches exception \a xid.
  *
@@ -566,6 +2135,106 @@ struct cx_impl_try_block {
  */
 bool cx_impl_catch( int xid, cx_impl_try_block_t *tb );
 
+/**
+ * Catches any of the exceptions \a xids.
+ *
+ * @param xids The exception IDs to catch.
+ * @param n_xids The number of exception IDs.
+ * @param tb A pointer to the current \ref cx_impl_try_block.
+ * @return Returns `true` only if any of \a xids was caught.
+ */
+bool cx_impl_catch_any_of( int const xids[], unsigned n_xids,
+                           cx_impl_try_block_t *tb );
+
+/**
+ * Catches any exception in the range [\a lo_xid, \a hi_xid].
+ *
+ * @param lo_xid The lowest exception ID to catch.
+ * @param hi_xid The highest exception ID to catch.
+ * @param tb A pointer to the current \ref cx_impl_try_block.
+ * @return Returns `true` only if an exception in the range was caught.
+ */
+bool cx_impl_catch_range( int lo_xid, int hi_xid, cx_impl_try_block_t *tb );
+
+/**
+ * Pops \a ms from both the list of open "try" blocks and the stack of
+ * #cx_try_with_matcher scopes.
+ *
+ * @param ms A pointer to the \ref cx_impl_matcher_scope to pop.
+ * @return Always returns NULL.
+ */
+cx_impl_matcher_scope_t* cx_impl_matcher_scope_pop(
+  cx_impl_matcher_scope_t *ms
+);
+
+/**
+ * Initializes \a ms and pushes it onto both the list of open "try" blocks
+ * and the stack of #cx_try_with_matcher scopes.
+ *
+ * @param ms A pointer to the \ref cx_impl_matcher_scope to initialize.
+ * @param fn The \ref cx_xid_matcher_t to use within the scope or NULL for the
+ * default.
+ * @return Returns \a ms.
+ */
+cx_impl_matcher_scope_t* cx_impl_matcher_scope_push(
+  cx_impl_matcher_scope_t *ms, cx_xid_matcher_t fn
+);
+
+/**
+ * Never defined nor called: it exists only so the compiler checks the
+ * arguments of a #cx_context against its format.
+ *
+ * @param format The format.
+ * @param ... The arguments.
+ * @return Never returns.
+ */
+CX_IMPL_PRINTF_LIKE(1)
+int cx_impl_context_check( char const *format, ... );
+
+/**
+ * Implements #cx_escape().
+ *
+ * @param escape_file The file whence #cx_escape() was called.
+ * @param escape_line The line number within \a escape_file.
+ * @param id The escape ID.
+ * @param value The value to assign to the #cx_escape_point's result.
+ */
+_Noreturn
+void cx_impl_escape( char const *escape_file, int escape_line, int id,
+                     void *value );
+
+/**
+ * Gets the value passed to the most recent #cx_escape().
+ *
+ * @return Returns said value.
+ */
+void* cx_impl_escape_value( void );
+
+/**
+ * Begins the coroutine "try" frame \a f and links it into the chain of "try"
+ * blocks.
+ *
+ * @param f A pointer to the \ref cx_co_try_t to begin.
+ * @param try_file The file containing the #cx_co_try().
+ * @param try_line The line number within \a try_file.
+ * @return Always returns `true`.
+ *
+ * @sa #cx_co_try()
+ */
+bool cx_impl_co_try_begin( cx_co_try_t *f, char const *try_file,
+                           int try_line );
+
+/**
+ * Relinks the coroutine "try" frame \a f, if begun, into the chain of "try"
+ * blocks.
+ *
+ * @param f A pointer to the \ref cx_co_try_t to relink.
+ * @return Returns `true` only if \a f was begun.
+ *
+ * @sa #cx_co_resume()
+ */
+bool cx_impl_co_try_relink( cx_co_try_t *f );
+
 /**
  * Implements #cx_cancel_try().
  *
@@ -575,19 +2244,63 @@ bool cx_impl_catch( int xid, cx_impl_try_block_t *tb );
  */
 void cx_impl_cancel_try( cx_impl_try_block_t const *tb );
 
+/**
+ * Implements #cx_throw() without arguments: rethrows the current exception
+ * retaining its user-data and payload.
+ *
+ * @param site The \ref cx_site whence the exception was rethrown.
+ * @param xid The exception ID to rethrow.
+ */
+_Noreturn
+void cx_impl_rethrow( cx_site_t const *site, int xid );
+
 /**
  * Implements #cx_throw()
  *
- * @param throw_file The file whence the exception wat thrown.
- * @param throw_line The line number within \a throw_file whence the exception
- * was thrown.
+ * @param site The \ref cx_site whence the exception was thrown.
+ * @param xid The exception ID to throw.  It may be any non-zero value.
+ * @param user_data Optional user-data copied into \ref cx_exception::user_data
+ * "user_data".
+ */
+_Noreturn
+void cx_impl_throw( cx_site_t const *site, int xid, void *user_data );
+
+/**
+ * Implements #cx_throw_nested().
+ *
+ * @param site The \ref cx_site whence the exception was thrown.
  * @param xid The exception ID to throw.  It may be any non-zero value.
  * @param user_data Optional user-data copied into \ref cx_exception::user_data
  * "user_data".
  */
 _Noreturn
-void cx_impl_throw( char const *throw_file, int throw_line, int xid,
-                    void *user_data );
+void cx_impl_throw_nested( cx_site_t const *site, int xid, void *user_data );
+
+/**
+ * Implements #cx_throwf().
+ *
+ * @param site The \ref cx_site whence the exception was thrown.
+ * @param xid The exception ID to throw.  It may be any non-zero value.
+ * @param format The `printf()` format.
+ * @param ... The arguments for \a format.
+ */
+_Noreturn CX_IMPL_PRINTF_LIKE(3)
+void cx_impl_throwf( cx_site_t const *site, int xid, char const *format, ... );
+
+/**
+ * Implements #cx_throw_value().
+ *
+ * @param site The \ref cx_site whence the exception was thrown.
+ * @param xid The exception ID to throw.  It may be any non-zero value.
+ * @param kind How to interpret the bytes of \a value.
+ * @param value A pointer to the value to copy into \ref cx_exception::payload
+ * "payload".
+ * @param size The size in bytes of \a value.
+ */
+_Noreturn
+void cx_impl_throw_value( cx_site_t const *site, int xid,
+                          cx_impl_payload_kind_t kind, void const *value,
+                          size_t size );
 
 /**
  * Checks whether the #cx_try, #cx_catch, or #cx_finally code should be
@@ -598,6 +2311,345 @@ void cx_impl_throw( char const *throw_file, int throw_line, int xid,
  */
 bool cx_impl_try_condition( cx_impl_try_block_t *tb );
 
+#ifdef CX_XID_MATCHER
+/**
+ * Marks the exception thrown to \a tb as caught.
+ *
+ * @param tb A pointer to the current \ref cx_impl_try_block.
+ * @return Always returns `true`.
+ */
+static inline bool cx_impl_caught_inline( cx_impl_try_block_t *tb ) {
+  tb->state = CX_IMPL_CAUGHT;
+  tb->caught_xid = tb->thrown_xid;
+  return true;
+}
+
+/**
+ * Like cx_impl_catch(), but uses #CX_XID_MATCHER.
+ *
+ * @param xid The exception ID to catch.  If #CX_XID_ANY, it is always caught.
+ * @param tb A pointer to the current \ref cx_impl_try_block.
+ * @return Returns `true` only if \a xid was caught.
+ */
+static inline bool cx_impl_catch_inline( int xid, cx_impl_try_block_t *tb ) {
+  // An exception can never be recaught at the same level.
+  return  tb->caught_xid != tb->thrown_xid &&
+          (xid == CX_XID_ANY || CX_XID_MATCHER( tb->thrown_xid, xid )) &&
+          cx_impl_caught_inline( tb );
+}
+
+/**
+ * Like cx_impl_catch_any_of(), but uses #CX_XID_MATCHER.
+ *
+ * @param xids The exception IDs to catch.
+ * @param n_xids The number of exception IDs.
+ * @param tb A pointer to the current \ref cx_impl_try_block.
+ * @return Returns `true` only if any of \a xids was caught.
+ */
+static inline bool cx_impl_catch_any_of_inline( int const xids[],
+                                                unsigned n_xids,
+                                                cx_impl_try_block_t *tb ) {
+  if ( tb->caught_xid == tb->thrown_xid )
+    return false;
+  for ( unsigned i = 0; i < n_xids; ++i ) {
+    if ( xids[i] == CX_XID_ANY || CX_XID_MATCHER( tb->thrown_xid, xids[i] ) )
+      return cx_impl_caught_inline( tb );
+  } // for
+  return false;
+}
+#endif /* CX_XID_MATCHER */
+
+#if CX_CANCEL_FINALLY || CX_JMP_BACKEND == CX_JMP_BACKEND_UNWIND
+/**
+ * Called by cx_impl_try_cleanup() when a #cx_try block that is still the
+ * current block goes out of scope because the stack is being unwound through
+ * it.
+ *
+ * @param tb A pointer to the \ref cx_impl_try_block going out of scope.
+ * @return Returns `true` only if \a tb must be resumed, either because
+ * #cx_throw is unwinding to it or because a foreign exception is unwinding
+ * through it and it has a #cx_finally block to run; otherwise removes it from
+ * the list of open blocks (only if #CX_CANCEL_FINALLY) and returns `false`.
+ */
+bool cx_impl_try_unwound( cx_impl_try_block_t *tb );
+
+/**
+ * Called when a #cx_try block goes out of scope.
+ *
+ * @param tb A pointer to the \ref cx_impl_try_block going out of scope.
+ *
+ * @note It's always inlined so that, for #CX_JMP_BACKEND_UNWIND,
+ * cx_impl_ctx_land() is called from the function containing \a tb.
+ */
+__attribute__((always_inline))
+static inline void cx_impl_try_cleanup( cx_impl_try_block_t *tb ) {
+  if ( cx_impl_try_block_head == tb && cx_impl_try_unwound( tb ) )
+    CX_IMPL_LAND( tb->env );
+}
+#endif /* CX_CANCEL_FINALLY || CX_JMP_BACKEND == CX_JMP_BACKEND_UNWIND */
+
+#if CX_CANCEL_FINALLY
+
+/**
+ * Called when a #cx_context scope goes out of scope.
+ *
+ * @param cs A pointer to the \ref cx_impl_context_scope going out of scope.
+ */
+static inline void cx_impl_context_cleanup( cx_impl_context_scope_t *cs ) {
+  if ( cx_impl_try_block_head == &cs->node ) {
+    cx_impl_try_block_head = cs->node.parent;
+    cx_impl_context_top = cs->outer;
+  }
+}
+
+/**
+ * Called when a #cx_try_with_matcher scope goes out of scope.
+ *
+ * @param ms A pointer to the \ref cx_impl_matcher_scope going out of scope.
+ */
+static inline void cx_impl_matcher_scope_cleanup( cx_impl_matcher_scope_t *ms ) {
+  if ( cx_impl_try_block_head == &ms->node )
+    cx_impl_matcher_scope_pop( ms );
+}
+#endif /* CX_CANCEL_FINALLY */
+
+/**
+ * Pushes \a tb onto the list of open "try" blocks.
+ *
+ * @param tb A pointer to the \ref cx_impl_try_block to push.  Its \ref
+ * cx_impl_try_block::parent "parent" must already be set.
+ */
+static inline void cx_impl_try_block_push( cx_impl_try_block_t *tb ) {
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 12
+# pragma GCC diagnostic push
+# pragma GCC diagnostic ignored "-Wdangling-pointer"
+#endif
+  cx_impl_try_block_head = tb;          // popped before tb goes out of scope
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 12
+# pragma GCC diagnostic pop
+#endif
+}
+
+/**
+ * Pops \a cs, a #cx_context scope, from the list of open "try" blocks.
+ *
+ * @param cs A pointer to the \ref cx_impl_context_scope to pop.
+ * @return Always returns NULL.
+ */
+static inline cx_impl_context_scope_t*
+cx_impl_context_pop( cx_impl_context_scope_t *cs ) {
+  cx_impl_try_block_head = cs->node.parent;
+  cx_impl_context_top = cs->outer;
+  return NULL;
+}
+
+/**
+ * Initializes \a cs as a #cx_context scope and pushes it onto the list of
+ * open "try" blocks.
+ *
+ * @param cs A pointer to the \ref cx_impl_context_scope to initialize.  Only
+ * the fields needed by a scope are set.
+ * @param context_file The file containing the #cx_context.
+ * @param context_line The line number within \a context_file.
+ * @param format The format.
+ * @param n_args The number of arguments.
+ * @param args The arguments.
+ * @return Returns \a cs.
+ */
+static inline cx_impl_context_scope_t*
+cx_impl_context_push( cx_impl_context_scope_t *cs, char const *context_file,
+                      int context_line, char const *format, unsigned n_args,
+                      union cx_impl_format_arg const args[] ) {
+  cs->node.state = CX_IMPL_CONTEXT;
+  cs->node.parent = cx_impl_try_block_head;
+  cs->node.try_line = context_line;
+  cs->node.try_file = context_file;
+  cs->context.format = format;
+  for ( unsigned i = 0; i < n_args; ++i )
+    cs->context.args[i] = args[i];
+  cs->outer = cx_impl_context_top;
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 12
+# pragma GCC diagnostic push
+# pragma GCC diagnostic ignored "-Wdangling-pointer"
+#endif
+  cx_impl_context_top = cs;             // popped before cs goes out of scope
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 12
+# pragma GCC diagnostic pop
+#endif
+  cx_impl_try_block_push( &cs->node );
+  return cs;
+}
+
+/**
+ * Records a floating-point argument of a #cx_context.
+ *
+ * @param d The argument.
+ * @return Returns said argument.
+ */
+static inline union cx_impl_format_arg cx_impl_format_arg_d( double d ) {
+  return (union cx_impl_format_arg){ .d = d };
+}
+
+/**
+ * Records an integer argument of a #cx_context.
+ *
+ * @param i The argument.
+ * @return Returns said argument.
+ */
+static inline union cx_impl_format_arg cx_impl_format_arg_i( long long i ) {
+  return (union cx_impl_format_arg){ .i = i };
+}
+
+/**
+ * Records a `long double` argument of a #cx_context as a `double`.
+ *
+ * @param ld The argument.
+ * @return Returns said argument.
+ */
+static inline union cx_impl_format_arg
+cx_impl_format_arg_ld( long double ld ) {
+  return (union cx_impl_format_arg){ .d = (double)ld };
+}
+
+/**
+ * Records a pointer argument of a #cx_context.
+ *
+ * @param p The argument.
+ * @return Returns said argument.
+ */
+static inline union cx_impl_format_arg cx_impl_format_arg_p( void const *p ) {
+  return (union cx_impl_format_arg){ .p = p };
+}
+
+/**
+ * Initializes \a nb as a #cx_noexcept barrier and pushes it onto the list of
+ * open "try" blocks.
+ *
+ * @param nb A pointer to the \ref cx_impl_try_block to initialize.  Only the
+ * fields needed by a barrier are set.
+ * @param noexcept_file The file containing the #cx_noexcept.
+ * @param noexcept_line The line number within \a noexcept_file.
+ * @return Returns \a nb.
+ */
+static inline cx_impl_try_block_t*
+cx_impl_noexcept_enter( cx_impl_try_block_t *nb, char const *noexcept_file,
+                        int noexcept_line ) {
+  nb->state = CX_IMPL_NOEXCEPT;
+  nb->parent = cx_impl_try_block_head;
+  nb->try_line = noexcept_line;
+  nb->try_file = noexcept_file;
+  cx_impl_try_block_push( nb );
+  return nb;
+}
+
+/**
+ * Pops \a nb, a #cx_noexcept barrier, from the list of open "try" blocks.
+ *
+ * @param nb A pointer to the \ref cx_impl_try_block to pop.
+ * @return Always returns NULL.
+ */
+static inline cx_impl_try_block_t*
+cx_impl_noexcept_exit( cx_impl_try_block_t *nb ) {
+  cx_impl_try_block_head = nb->parent;
+  return NULL;
+}
+
+/**
+ * Initializes \a eb as a #cx_escape_point and pushes it onto the list of open
+ * "try" blocks.
+ *
+ * @param eb A pointer to the \ref cx_impl_try_block to initialize.  Only the
+ * fields needed by an escape point are set.
+ * @param escape_file The file containing the #cx_escape_point.
+ * @param escape_line The line number within \a escape_file.
+ * @param id The escape ID.
+ * @return Returns \a eb.
+ */
+static inline cx_impl_try_block_t*
+cx_impl_escape_enter( cx_impl_try_block_t *eb, char const *escape_file,
+                      int escape_line, int id ) {
+  eb->state = CX_IMPL_ESCAPE;
+  eb->parent = cx_impl_try_block_head;
+  eb->caught_xid = id;                  // reused as the escape ID
+  eb->try_line = escape_line;
+  eb->try_file = escape_file;
+  cx_impl_try_block_push( eb );
+  return eb;
+}
+
+/**
+ * Pops \a eb, a #cx_escape_point, from the list of open "try" blocks.
+ *
+ * @param eb A pointer to the \ref cx_impl_try_block to pop.
+ * @return Always returns NULL.
+ */
+static inline cx_impl_try_block_t*
+cx_impl_escape_exit( cx_impl_try_block_t *eb ) {
+  cx_impl_try_block_head = eb->parent;
+  return NULL;
+}
+
+#if CX_INLINE_FAST_PATH
+/**
+ * Initializes \a tb and pushes it onto the list of open "try" blocks.
+ *
+ * @param tb A pointer to the \ref cx_impl_try_block to initialize.  Its jump
+ * buffer is not touched.
+ * @param try_file The file containing the #cx_try.
+ * @param try_line The line number within \a try_file.
+ * @param catch_xids The \ref cx_impl_try_block::catch_xids "catch_xids", if
+ * any.
+ * @return Returns \a tb.
+ */
+static inline cx_impl_try_block_t*
+cx_impl_try_enter( cx_impl_try_block_t *tb, char const *try_file,
+                   int try_line, int const *catch_xids ) {
+  tb->state = CX_IMPL_INIT;
+  tb->thrown_xid = 0;
+  tb->parent = cx_impl_try_block_head;
+  tb->caught_xid = 0;
+  tb->try_line = try_line;
+  tb->catch_xids = catch_xids;
+  tb->try_file = try_file;
+#ifndef NDEBUG
+  tb->try_condition_calls = 0;
+#endif /* NDEBUG */
+  cx_impl_try_block_push( tb );
+  return tb;
+}
+
+/**
+ * Inline version of cx_impl_try_condition() that handles only the cases when
+ * no exception was thrown; all other cases are handled by calling
+ * cx_impl_try_condition().
+ *
+ * @param tb A pointer to the current \ref cx_impl_try_block.
+ * @return Returns `true` only if the code should be executed.
+ */
+static inline bool cx_impl_try_condition_fast( cx_impl_try_block_t *tb ) {
+  switch ( tb->state ) {
+    case CX_IMPL_INIT:
+      tb->state = CX_IMPL_TRY;
+      return true;
+    case CX_IMPL_TRY:
+      if ( tb != cx_impl_try_block_head )
+        break;                          // let it report the error
+      tb->state = CX_IMPL_FINALLY;
+      return true;
+    case CX_IMPL_FINALLY:
+      if ( tb != cx_impl_try_block_head ||
+           tb->thrown_xid != 0 || tb->caught_xid != 0 ) {
+        break;
+      }
+      cx_impl_try_block_head = tb->parent;
+      return false;
+    default:
+      break;
+  } // switch
+  return cx_impl_try_condition( tb );
+}
+#endif /* CX_INLINE_FAST_PATH */
+
 /** @} */
 
 ///////////////////////////////////////////////////////////////////////////////
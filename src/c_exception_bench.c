@@ -0,0 +1,278 @@
+/*
+**      C Exception -- Exception Library for C
+**      src/c_exception_bench.c
+**
+**      Copyright (C) 2023-2024  Paul J. Lucas
+**
+**      This program is free software: you can redistribute it and/or modify
+**      it under the terms of the GNU General Public License as published by
+**      the Free Software Foundation, either version 3 of the License, or
+**      (at your option) any later version.
+**
+**      This program is distributed in the hope that it will be useful,
+**      but WITHOUT ANY WARRANTY; without even the implied warranty of
+**      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**      GNU General Public License for more details.
+**
+**      You should have received a copy of the GNU General Public License
+**      along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * Micro-benchmarks for C Exception.  Run via `make bench`, which builds and
+ * runs one program per #CX_JMP_BACKEND.
+ */
+
+// local
+#include "config.h"                     /* must go first */
+#include "c_exception.h"
+#include "cx_cancel.h"
+
+// standard
+#include <attribute.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sysexits.h>
+#include <time.h>
+
+///////////////////////////////////////////////////////////////////////////////
+
+#define BENCH_ITERATIONS  10000000UL
+#define BENCH_XID         0x0101
+
+/**
+ * The signature for a benchmark function.
+ *
+ * @param n The number of iterations to run.
+ */
+typedef void (*bench_fn_t)( unsigned long n );
+
+// local variables
+static unsigned long volatile bench_sink;
+
+////////// local functions ////////////////////////////////////////////////////
+
+/**
+ * Runs \a fn and prints the average time per iteration.
+ *
+ * @param name The name of the benchmark.
+ * @param fn The benchmark function to run.
+ * @param n The number of iterations to run.
+ */
+static void bench_run( char const *name, bench_fn_t fn, unsigned long n ) {
+  struct timespec start, end;
+  (*fn)( n / 10 );                      // warm up
+  clock_gettime( CLOCK_MONOTONIC, &start );
+  (*fn)( n );
+  clock_gettime( CLOCK_MONOTONIC, &end );
+  double const ns = (double)(end.tv_sec - start.tv_sec) * 1e9
+                  + (double)(end.tv_nsec - start.tv_nsec);
+  printf( "%-36s %8.2f ns/iteration\n", name, ns / (double)n );
+}
+
+/**
+ * Gets the name of the configured #CX_JMP_BACKEND.
+ *
+ * @return Returns said name.
+ */
+static char const* bench_jmp_backend_name( void ) {
+#if   CX_JMP_BACKEND == CX_JMP_BACKEND_BUILTIN
+  return "builtin";
+#elif CX_JMP_BACKEND == CX_JMP_BACKEND_SIGSETJMP
+  return "sigsetjmp";
+#elif CX_JMP_BACKEND == CX_JMP_BACKEND_X86_64
+  return "x86_64";
+#elif CX_JMP_BACKEND == CX_JMP_BACKEND_UNWIND
+  return "unwind";
+#else
+  return "libc";
+#endif /* CX_JMP_BACKEND */
+}
+
+////////// benchmarks /////////////////////////////////////////////////////////
+
+ATTRIBUTE_NOINLINE
+static void bench_libc_setjmp( unsigned long n ) {
+  jmp_buf env;
+  for ( unsigned long i = 0; i < n; ++i ) {
+    if ( setjmp( env ) == 0 )
+      ++bench_sink;
+  } // for
+}
+
+ATTRIBUTE_NOINLINE
+static void bench_sigsetjmp( unsigned long n ) {
+  sigjmp_buf env;
+  for ( unsigned long i = 0; i < n; ++i ) {
+    if ( sigsetjmp( env, 0 ) == 0 )
+      ++bench_sink;
+  } // for
+}
+
+#ifdef __GNUC__
+ATTRIBUTE_NOINLINE
+static void bench_builtin_setjmp( unsigned long n ) {
+  void *env[5];
+  for ( unsigned long i = 0; i < n; ++i ) {
+    if ( __builtin_setjmp( env ) == 0 )
+      ++bench_sink;
+  } // for
+}
+#endif /* __GNUC__ */
+
+ATTRIBUTE_NOINLINE
+static void bench_try_no_throw( unsigned long n ) {
+  for ( unsigned long i = 0; i < n; ++i ) {
+    cx_try {
+      ++bench_sink;
+    }
+    cx_catch( BENCH_XID ) {
+      --bench_sink;
+    }
+  } // for
+}
+
+ATTRIBUTE_NOINLINE
+static void bench_try_throw( unsigned long n ) {
+  for ( unsigned long i = 0; i < n; ++i ) {
+    cx_try {
+      cx_throw( BENCH_XID );
+    }
+    cx_catch( BENCH_XID ) {
+      ++bench_sink;
+    }
+  } // for
+}
+
+ATTRIBUTE_NOINLINE
+static void bench_try_throwf( unsigned long n ) {
+  for ( unsigned long i = 0; i < n; ++i ) {
+    cx_try {
+      cx_throwf( BENCH_XID, "iteration %lu of %lu failed", i, n );
+    }
+    cx_catch( BENCH_XID ) {
+      ++bench_sink;
+    }
+  } // for
+}
+
+ATTRIBUTE_NOINLINE
+static void bench_try_throw_value( unsigned long n ) {
+  for ( unsigned long i = 0; i < n; ++i ) {
+    cx_try {
+      cx_throw_value( BENCH_XID, "value" );
+    }
+    cx_catch( BENCH_XID ) {
+      bench_sink += (unsigned char)*cx_payload_string( cx_current_exception() );
+    }
+  } // for
+}
+
+ATTRIBUTE_NOINLINE
+static void bench_context( unsigned long n ) {
+  for ( unsigned long i = 0; i < n; ++i ) {
+    cx_context( "iteration %lu of %lu", i, n ) {
+      ++bench_sink;
+    }
+  } // for
+}
+
+ATTRIBUTE_NOINLINE
+static void bench_noexcept( unsigned long n ) {
+  for ( unsigned long i = 0; i < n; ++i ) {
+    cx_noexcept {
+      ++bench_sink;
+    }
+  } // for
+}
+
+ATTRIBUTE_NOINLINE
+static void bench_check_cancel( unsigned long n ) {
+  cx_cancel_token_t token = CX_CANCEL_TOKEN_INIT;
+  cx_try {
+    for ( unsigned long i = 0; i < n; ++i ) {
+      cx_check_cancel( &token );
+      ++bench_sink;
+    } // for
+  }
+  cx_catch( CX_XID_CANCELLED ) {
+    bench_sink = 0;
+  }
+}
+
+ATTRIBUTE_NOINLINE
+static void bench_state_swap( unsigned long n ) {
+  cx_fiber_state_t a = CX_FIBER_STATE_INIT, b = CX_FIBER_STATE_INIT;
+  for ( unsigned long i = 0; i < n; ++i ) {
+    cx_state_swap( &a, &b );
+    cx_state_swap( &b, &a );
+  } // for
+}
+
+ATTRIBUTE_NOINLINE
+static void bench_try_volatile_loop( unsigned long n ) {
+  unsigned long volatile sum = 0;
+  cx_try {
+    for ( unsigned long volatile i = 0; i < n; ++i )
+      sum += i;
+  }
+  cx_catch( BENCH_XID ) {
+    sum = 0;
+  }
+  bench_sink = sum;
+}
+
+/**
+ * The function called by bench_invoke_loop().
+ *
+ * @param ctx A pointer to the number of iterations.
+ */
+static void bench_invoke_loop_fn( void *ctx ) {
+  unsigned long const n = *(unsigned long*)ctx;
+  unsigned long sum = 0;
+  for ( unsigned long i = 0; i < n; ++i ) {
+    sum += i;
+    __asm__ ( "" : "+r" (sum) );        // prevent loop closed-form
+  } // for
+  bench_sink = sum;
+}
+
+ATTRIBUTE_NOINLINE
+static void bench_invoke_loop( unsigned long n ) {
+  if ( cx_invoke( &bench_invoke_loop_fn, &n, NULL ) )
+    bench_sink = 0;
+}
+
+int main( void ) {
+  unsigned long const n = BENCH_ITERATIONS;
+
+  printf( "context save (no throw):\n" );
+  bench_run( "  libc setjmp()", &bench_libc_setjmp, n );
+  bench_run( "  sigsetjmp(env,0)", &bench_sigsetjmp, n );
+#ifdef __GNUC__
+  bench_run( "  __builtin_setjmp()", &bench_builtin_setjmp, n );
+#endif /* __GNUC__ */
+
+  printf( "cx_try (CX_JMP_BACKEND = %s, CX_INLINE_FAST_PATH = %d):\n",
+    bench_jmp_backend_name(), CX_INLINE_FAST_PATH
+  );
+  bench_run( "  try entry, no throw", &bench_try_no_throw, n );
+  bench_run( "  throw & catch", &bench_try_throw, n / 10 );
+  bench_run( "  throw value & catch", &bench_try_throw_value, n / 10 );
+  bench_run( "  throwf & catch", &bench_try_throwf, n / 10 );
+  bench_run( "  noexcept entry", &bench_noexcept, n );
+  bench_run( "  context entry", &bench_context, n );
+  bench_run( "  cx_state_swap() x 2", &bench_state_swap, n );
+
+  printf( "loop body:\n" );
+  bench_run( "  cx_try with volatile locals", &bench_try_volatile_loop, n );
+  bench_run( "  cx_invoke()", &bench_invoke_loop, n );
+  bench_run( "  cx_check_cancel()", &bench_check_cancel, n );
+
+  exit( EX_OK );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/* vim:set et sw=2 ts=2: */
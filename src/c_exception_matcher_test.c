@@ -0,0 +1,118 @@
+/*
+**      C Exception -- Exception Library for C
+**      src/c_exception_matcher_test.c
+**
+**      Copyright (C) 2023-2024  Paul J. Lucas
+**
+**      This program is free software: you can redistribute it and/or modify
+**      it under the terms of the GNU General Public License as published by
+**      the Free Software Foundation, either version 3 of the License, or
+**      (at your option) any later version.
+**
+**      This program is distributed in the hope that it will be useful,
+**      but WITHOUT ANY WARRANTY; without even the implied warranty of
+**      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**      GNU General Public License for more details.
+**
+**      You should have received a copy of the GNU General Public License
+**      along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * Tests #CX_XID_MATCHER.
+ */
+
+// local
+#include "config.h"                     /* must go first */
+
+// standard
+#include <stdbool.h>
+
+/**
+ * Matches any exception ID in the same group as a group exception ID (one
+ * whose low byte is 0).
+ *
+ * @param thrown_xid The thrown exception ID.
+ * @param catch_xid The exception ID to match \a thrown_xid against.
+ * @return Returns `true` only if \a thrown_xid matches \a catch_xid.
+ */
+static inline bool test_xid_matcher( int thrown_xid, int catch_xid ) {
+  if ( (catch_xid & 0x00FF) == 0x00 )
+    thrown_xid &= 0xFF00;
+  return thrown_xid == catch_xid;
+}
+
+#define CX_XID_MATCHER  test_xid_matcher
+
+// local
+#include "c_exception.h"
+#include "unit_test.h"
+
+// standard
+#include <stdio.h>
+#include <stdlib.h>
+#include <sysexits.h>
+
+///////////////////////////////////////////////////////////////////////////////
+
+// extern variables
+char const       *me;
+
+// local variables
+static unsigned   test_failures;
+
+#define TEST_XID_ANY  0x0100
+#define TEST_XID_01   0x0101
+#define TEST_XID_02   0x0102
+
+////////// local functions ////////////////////////////////////////////////////
+
+static bool test_compile_time_matcher( void ) {
+  TEST_FN_BEGIN();
+  unsigned volatile n_catch_1 = 0, n_catch_any = 0;
+  cx_try {
+    cx_throw( TEST_XID_02 );
+  }
+  cx_catch( TEST_XID_01 ) {
+    ++n_catch_1;
+  }
+  cx_catch( TEST_XID_ANY ) {
+    ++n_catch_any;
+  }
+  TEST( n_catch_1 == 0 );
+  TEST( n_catch_any == 1 );
+  TEST( cx_current_exception() == NULL );
+  TEST_FN_END();
+}
+
+static bool test_compile_time_matcher_any_of( void ) {
+  TEST_FN_BEGIN();
+  unsigned volatile n_catch = 0;
+  cx_try {
+    cx_throw( TEST_XID_02 );
+  }
+  cx_catch( 0x0200, TEST_XID_ANY ) {
+    ++n_catch;
+  }
+  TEST( n_catch == 1 );
+  TEST( cx_current_exception() == NULL );
+  TEST_FN_END();
+}
+
+int main( int argc, char const *argv[] ) {
+  (void)argc;
+  me = argv[0];
+
+  // The runtime matcher must not be used.
+  TEST( cx_get_xid_matcher() == NULL );
+
+  test_compile_time_matcher();
+  test_compile_time_matcher_any_of();
+
+  printf( "%u failures\n", test_failures );
+  exit( test_failures > 0 ? EX_SOFTWARE : EX_OK );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/* vim:set et sw=2 ts=2: */
@@ -21,12 +21,27 @@
 // local
 #include "config.h"                     /* must go first */
 #include "c_exception.h"
+#ifdef TEST_FIBERS
+#include "fiber_sched.h"
+#define TEST_YIELD()  fiber_yield()
+#endif /* TEST_FIBERS */
 #include "unit_test.h"
 
 // standard
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#include <sched.h>
+#endif /* HAVE_PTHREAD_H */
+#include <limits.h>
+#include <setjmp.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sysexits.h>
+#include <unistd.h>
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -38,13 +53,40 @@ static unsigned   test_failures;
 
 ////////// local functions ////////////////////////////////////////////////////
 
+// The fields accessed on every state transition must be first.
+_Static_assert(
+  offsetof( cx_impl_try_block_t, parent ) + sizeof(cx_impl_try_block_t*) <= 16,
+  "cx_impl_try_block_t: hot fields not first"
+);
+
+#if CX_JMP_BACKEND == CX_JMP_BACKEND_X86_64
+// The entire try block, except the debugging-only loop guard, must fit within
+// a single 64-byte cache line.
+#ifdef NDEBUG
+_Static_assert(
+  sizeof(cx_impl_try_block_t) <= 64, "cx_impl_try_block_t: > 64 bytes"
+);
+#else
+_Static_assert(
+  offsetof( cx_impl_try_block_t, try_condition_calls ) <= 64,
+  "cx_impl_try_block_t: > 64 bytes"
+);
+#endif /* NDEBUG */
+#endif /* CX_JMP_BACKEND == CX_JMP_BACKEND_X86_64 */
+
 #define TEST_XID_ANY  0x0100
 #define TEST_XID_01   0x0101
 #define TEST_XID_02   0x0102
+#define TEST_XID_03   0x0103
+#define TEST_XID_04   0x0104
+
+#ifdef TEST_FIBERS
+#define TEST_N_FIBERS 8
+#endif /* TEST_FIBERS */
 
 static bool test_no_throw( void ) {
   TEST_FN_BEGIN();
-  unsigned n_try = 0, n_catch = 0, n_finally = 0;
+  unsigned volatile n_try = 0, n_catch = 0, n_finally = 0;
   cx_try {
     ++n_try;
   }
@@ -65,7 +107,7 @@ static bool test_no_throw( void ) {
 static bool test_throw_catch_1( void ) {
   TEST_FN_BEGIN();
   unsigned volatile n_try = 0;
-  unsigned n_catch_1 = 0, n_catch_2 = 0, n_finally = 0;
+  unsigned volatile n_catch_1 = 0, n_catch_2 = 0, n_finally = 0;
   cx_try {
     ++n_try;
     cx_throw( TEST_XID_01 );
@@ -92,7 +134,7 @@ static bool test_throw_catch_1( void ) {
 static bool test_throw_catch_2( void ) {
   TEST_FN_BEGIN();
   unsigned volatile n_try = 0;
-  unsigned n_catch_1 = 0, n_catch_2 = 0, n_finally = 0;
+  unsigned volatile n_catch_1 = 0, n_catch_2 = 0, n_finally = 0;
   cx_try {
     ++n_try;
     cx_throw( TEST_XID_02 );
@@ -119,7 +161,7 @@ static bool test_throw_catch_2( void ) {
 static bool test_throw_catch_all( void ) {
   TEST_FN_BEGIN();
   unsigned volatile n_try = 0;
-  unsigned n_catch = 0, n_finally = 0;
+  unsigned volatile n_catch = 0, n_finally = 0;
   cx_try {
     ++n_try;
     cx_throw( TEST_XID_01 );
@@ -145,7 +187,7 @@ static void test_throw_from_a_called_function_function( int xid ) {
 static bool test_throw_from_a_called_function( void ) {
   TEST_FN_BEGIN();
   unsigned volatile n_try = 0;
-  unsigned n_catch = 0, n_finally = 0;
+  unsigned volatile n_catch = 0, n_finally = 0;
   cx_try {
     ++n_try;
     test_throw_from_a_called_function_function( TEST_XID_01 );
@@ -165,6 +207,43 @@ static bool test_throw_from_a_called_function( void ) {
   TEST_FN_END();
 }
 
+#if CX_JMP_BACKEND == CX_JMP_BACKEND_UNWIND
+static void test_unwind_cleanup( unsigned **pn ) {
+  ++**pn;
+}
+
+static void test_unwind_function( unsigned *n_cleanups ) {
+  unsigned *pn __attribute__((cleanup(test_unwind_cleanup))) = n_cleanups;
+  (void)pn;
+  cx_try {
+    unsigned *pn2 __attribute__((cleanup(test_unwind_cleanup))) = n_cleanups;
+    (void)pn2;
+    cx_throw( TEST_XID_01 );
+  }
+  cx_catch( TEST_XID_02 ) {             // doesn't match: rethrown
+  }
+}
+
+static bool test_unwind_cleanups( void ) {
+  TEST_FN_BEGIN();
+  unsigned n_cleanups = 0;
+  unsigned volatile n_catch = 0;
+  cx_try {
+    unsigned *pn __attribute__((cleanup(test_unwind_cleanup))) = &n_cleanups;
+    (void)pn;
+    test_unwind_function( &n_cleanups );
+  }
+  cx_catch( TEST_XID_01 ) {
+    ++n_catch;
+  }
+  TEST( n_catch == 1 );
+  // Both in test_unwind_function() and the one in the cx_try block above.
+  TEST( n_cleanups == 3 );
+  TEST( cx_current_exception() == NULL );
+  TEST_FN_END();
+}
+#endif /* CX_JMP_BACKEND == CX_JMP_BACKEND_UNWIND */
+
 static bool test_xid_matcher( int thrown_xid, int catch_xid ) {
   if ( (catch_xid & 0x00FF) == 0x00 )
     thrown_xid &= 0xFF00;
@@ -190,11 +269,58 @@ static bool test_custom_xid_matcher( void ) {
   TEST_FN_END();
 }
 
+static bool test_try_with_matcher( void ) {
+  TEST_FN_BEGIN();
+  unsigned volatile n_inner_catch = 0;
+  unsigned volatile n_outer_catch = 0;
+  cx_try {
+    cx_try_with_matcher( &test_xid_matcher ) {
+      cx_try {
+        cx_throw( TEST_XID_01 );
+      }
+      cx_catch( TEST_XID_ANY ) {
+        ++n_inner_catch;
+      }
+      cx_throw( TEST_XID_02 );
+    }
+    cx_catch( TEST_XID_01 ) {           // doesn't match TEST_XID_02
+      TEST( false );
+    }
+  }
+  cx_catch( TEST_XID_ANY ) {            // default matcher: doesn't match
+    TEST( false );
+  }
+  cx_catch( TEST_XID_02 ) {
+    ++n_outer_catch;
+  }
+  TEST( n_inner_catch == 1 );
+  TEST( n_outer_catch == 1 );
+  TEST( cx_get_xid_matcher() == NULL );
+  TEST( cx_current_exception() == NULL );
+  TEST_FN_END();
+}
+
+static bool test_thread_xid_matcher( void ) {
+  TEST_FN_BEGIN();
+  TEST( cx_set_thread_xid_matcher( &test_xid_matcher ) == NULL );
+  unsigned volatile n_catch = 0;
+  cx_try {
+    cx_throw( TEST_XID_01 );
+  }
+  cx_catch( TEST_XID_ANY ) {
+    ++n_catch;
+  }
+  TEST( cx_set_thread_xid_matcher( NULL ) == &test_xid_matcher );
+  TEST( n_catch == 1 );
+  TEST( cx_get_xid_matcher() == NULL );
+  TEST_FN_END();
+}
+
 static bool test_throw_from_nested_catch( void ) {
   TEST_FN_BEGIN();
   unsigned volatile n_inner_try = 0, n_outer_try = 0;
   unsigned volatile n_inner_catch = 0, n_inner_finally = 0;
-  unsigned n_outer_catch = 0, n_outer_finally = 0;
+  unsigned volatile n_outer_catch = 0, n_outer_finally = 0;
   cx_try {
     ++n_outer_try;
     cx_try {
@@ -229,7 +355,7 @@ static bool test_rethrow_in_catch( void ) {
   TEST_FN_BEGIN();
   unsigned volatile n_inner_try = 0, n_outer_try = 0;
   unsigned volatile n_inner_catch = 0, n_inner_finally = 0;
-  unsigned n_outer_catch = 0, n_outer_finally = 0;
+  unsigned volatile n_outer_catch = 0, n_outer_finally = 0;
   cx_try {
     ++n_outer_try;
     cx_try {
@@ -263,7 +389,7 @@ static bool test_rethrow_in_catch( void ) {
 static bool test_throw_with_user_data( void ) {
   TEST_FN_BEGIN();
   unsigned volatile n_try = 0;
-  unsigned n_catch = 0;
+  unsigned volatile n_catch = 0;
   int user_data = 0;
   cx_try {
     ++n_try;
@@ -281,19 +407,972 @@ static bool test_throw_with_user_data( void ) {
   TEST_FN_END();
 }
 
-int main( int argc, char const *argv[] ) {
-  (void)argc;
-  me = argv[0];
+static bool test_throw_nested( void ) {
+  TEST_FN_BEGIN();
+  unsigned volatile n_catch = 0;
+  cx_exception_ptr_t *volatile xp = NULL;
+  cx_try {
+    cx_try {
+      cx_try {
+        cx_throw( TEST_XID_01 );
+      }
+      cx_catch( TEST_XID_01 ) {
+        cx_throw_nested( TEST_XID_02 );
+      }
+    }
+    cx_finally {
+      cx_throw_nested( TEST_XID_03 );
+    }
+  }
+  cx_catch( TEST_XID_03 ) {
+    ++n_catch;
+    cx_exception_t const *const cex = cx_current_exception();
+    if ( TEST( cex->cause != NULL ) ) {
+      TEST( cex->cause->thrown_xid == TEST_XID_02 );
+      if ( TEST( cex->cause->cause != NULL ) ) {
+        TEST( cex->cause->cause->thrown_xid == TEST_XID_01 );
+        TEST( cex->cause->cause->cause == NULL );
+      }
+    }
+    xp = cx_exception_ptr_capture();
+  }
+  TEST( n_catch == 1 );
+  TEST( cx_current_exception() == NULL );
+  if ( TEST( xp != NULL ) ) {
+    cx_exception_t const *const cex = cx_exception_ptr_exception( xp );
+    if ( TEST( cex->cause != NULL ) && TEST( cex->cause->cause != NULL ) )
+      TEST( cex->cause->cause->thrown_xid == TEST_XID_01 );
+    cx_exception_ptr_release( xp );
+  }
+  TEST_FN_END();
+}
+
+static void test_throw_nested_deep_fn( unsigned depth ) {
+  cx_try {
+    if ( depth == 0 )
+      cx_throw( TEST_XID_01 );
+    test_throw_nested_deep_fn( depth - 1 );
+  }
+  cx_catch() {
+    cx_throw_nested( TEST_XID_02 );
+  }
+}
+
+static bool test_throw_nested_deep( void ) {
+  TEST_FN_BEGIN();
+  unsigned volatile n_catch = 0;
+  cx_try {
+    test_throw_nested_deep_fn( 200 );
+  }
+  cx_catch( TEST_XID_02 ) {
+    ++n_catch;
+    unsigned n_causes = 0;
+    cx_exception_t const *root = NULL;
+    for ( cx_exception_t const *cex = cx_current_exception()->cause;
+          cex != NULL; cex = cex->cause ) {
+      ++n_causes;
+      root = cex;
+    } // for
+    // The pool ran dry, so the chain was truncated to one chunk's worth
+    // (fewer with fibers since others may hold some) keeping the root cause.
+#ifdef TEST_FIBERS
+    TEST( n_causes <= CX_CAUSE_MAX );
+#else
+    TEST( n_causes == CX_CAUSE_MAX );
+#endif /* TEST_FIBERS */
+    if ( n_causes > 1 )
+      TEST( root->thrown_xid == TEST_XID_01 );
+  }
+  TEST( n_catch == 1 );
+  TEST_FN_END();
+}
+
+static bool test_throwf( void ) {
+  TEST_FN_BEGIN();
+  unsigned volatile n_catch = 0;
+  cx_exception_ptr_t *volatile xp = NULL;
+
+  cx_try {
+    cx_throwf( TEST_XID_01, "a=%d s=%s f=%5.2f z=%zu d=%zd c=%c %%",
+               -3, "str", 3.14159, (size_t)42, (ssize_t)-5, 'x' );
+  }
+  cx_catch( TEST_XID_01 ) {
+    ++n_catch;
+    // The message buffer is per-thread: check it before TEST() yields.
+    char const *const msg = cx_exception_message( cx_current_exception() );
+    bool const ok =
+      msg != NULL && strcmp( msg, "a=-3 s=str f= 3.14 z=42 d=-5 c=x %" ) == 0;
+    TEST( ok );
+  }
+
+  cx_try {
+    cx_throwf( TEST_XID_01, "[%*d|%-*.*s|%llx]", 4, 7, 5, 2, "abcdef", 255ULL );
+  }
+  cx_catch( TEST_XID_01 ) {
+    ++n_catch;
+    xp = cx_exception_ptr_capture();
+  }
+  if ( TEST( xp != NULL ) ) {
+    char const *const msg =
+      cx_exception_message( cx_exception_ptr_exception( xp ) );
+    bool const ok = msg != NULL && strcmp( msg, "[   7|ab   |ff]" ) == 0;
+    TEST( ok );
+    cx_exception_ptr_release( xp );
+  }
+
+  static char long_str[ CX_MESSAGE_SIZE_MAX * 2 ];
+  memset( long_str, 'x', sizeof long_str - 1 );
+  cx_try {
+    cx_throwf( TEST_XID_01, "%s", long_str );
+  }
+  cx_catch( TEST_XID_01 ) {
+    ++n_catch;
+    char const *const msg = cx_exception_message( cx_current_exception() );
+    bool const ok = msg != NULL && strlen( msg ) == CX_MESSAGE_SIZE_MAX - 1;
+    TEST( ok );
+  }
+
+  cx_try {
+    cx_throw( TEST_XID_01 );
+  }
+  cx_catch( TEST_XID_01 ) {
+    ++n_catch;
+    TEST( cx_exception_message( cx_current_exception() ) == NULL );
+  }
+
+  TEST( n_catch == 4 );
+  TEST_FN_END();
+}
+
+struct test_payload {
+  int     line;
+  int     col;
+  char    name[16];
+};
+
+static void test_throw_value_local( void ) {
+  char buf[ CX_PAYLOAD_SIZE_MAX * 2 ];
+  memset( buf, 'x', sizeof buf - 1 );
+  buf[ sizeof buf - 1 ] = '\0';
+  cx_throw_value( TEST_XID_02, buf );
+}
+
+static void test_context_nest( unsigned depth ) {
+  cx_context( "depth %u", depth ) {
+    if ( depth == 0 )
+      cx_throw( TEST_XID_01 );
+    test_context_nest( depth - 1 );
+  }
+}
+
+static bool test_context( void ) {
+  TEST_FN_BEGIN();
+  unsigned volatile n_catch = 0;
+
+  cx_try {
+    cx_context( "file %s", "a.csv" ) {
+      for ( unsigned n = 1; n <= 7; ++n ) {
+        cx_context( "record %u of %.*f", n, 1, 9.0 ) {
+          if ( n == 7 )
+            cx_throw( TEST_XID_01 );
+        }
+      } // for
+    }
+  }
+  cx_catch( TEST_XID_01 ) {
+    ++n_catch;
+    // The message buffer is per-thread: check it before TEST() yields.
+    cx_exception_t const *const cex = cx_current_exception();
+    bool const ok = cex->n_contexts == 2 &&
+      strcmp( cx_exception_context( cex, 0 ), "record 7 of 9.0" ) == 0 &&
+      strcmp( cx_exception_context( cex, 1 ), "file a.csv" ) == 0 &&
+      cx_exception_context( cex, 2 ) == NULL;
+    TEST( ok );
+  }
+
+  cx_try {
+    cx_context( "outer" ) {
+      cx_try {
+        cx_context( "inner" ) {
+          cx_throw( TEST_XID_01 );
+        }
+      }
+      cx_catch( TEST_XID_01 ) {
+        ++n_catch;
+        cx_throw();                     // rethrow keeps "inner"
+      }
+    }
+  }
+  cx_catch( TEST_XID_01 ) {
+    ++n_catch;
+    cx_exception_t const *const cex = cx_current_exception();
+    bool const ok = cex->n_contexts == 2 &&
+      strcmp( cx_exception_context( cex, 0 ), "inner" ) == 0;
+    TEST( ok );
+  }
+
+  cx_try {
+    test_context_nest( CX_CONTEXT_MAX );
+  }
+  cx_catch( TEST_XID_01 ) {
+    ++n_catch;
+    cx_exception_t const *const cex = cx_current_exception();
+    bool const ok = cex->n_contexts == CX_CONTEXT_MAX &&
+      strcmp( cx_exception_context( cex, 0 ), "depth 0" ) == 0;
+    TEST( ok );
+  }
+
+  cx_try {
+    cx_throw( TEST_XID_01 );            // all contexts have been exited
+  }
+  cx_catch( TEST_XID_01 ) {
+    ++n_catch;
+    TEST( cx_current_exception()->n_contexts == 0 );
+  }
+  TEST( cx_impl_context_top == NULL );  // so throws needn't look for any
+
+  cx_try {
+    cx_context( "kept" ) {
+      cx_try {
+        cx_context( "skipped" ) {
+          cx_throw( TEST_XID_01 );
+        }
+      }
+      cx_catch( TEST_XID_01 ) {
+        ++n_catch;
+      }
+      cx_throw( TEST_XID_02 );          // "skipped" was never popped
+    }
+  }
+  cx_catch( TEST_XID_02 ) {
+    ++n_catch;
+    cx_exception_t const *const cex = cx_current_exception();
+    bool const ok = cex->n_contexts == 1 &&
+      strcmp( cx_exception_context( cex, 0 ), "kept" ) == 0;
+    TEST( ok );
+  }
+
+  TEST( n_catch == 7 );
+  TEST_FN_END();
+}
+
+static bool test_sites( void ) {
+  TEST_FN_BEGIN();
+  size_t n_sites = 0;
+  cx_site_t const *const sites = cx_get_sites( &n_sites );
+  cx_site_t const *volatile site = NULL;
+  int volatile throw_line = 0;
+
+  cx_try {
+    throw_line = __LINE__; cx_throw( TEST_XID_01 );
+  }
+  cx_catch( TEST_XID_01 ) {
+    site = cx_current_exception()->thrown_site;
+  }
+
+  if ( TEST( site != NULL ) ) {
+    TEST( site->line == throw_line );
+    TEST( strcmp( site->file, __FILE__ ) == 0 );
+    TEST( strcmp( site->func, __func__ ) == 0 );
+#ifdef __ELF__
+    if ( TEST( sites != NULL ) ) {
+      size_t const id = cx_site_id( site );
+      if ( TEST( id < n_sites ) )
+        TEST( &sites[ id ] == site );
+      bool all_ok = true;
+      for ( size_t i = 0; i < n_sites; ++i )
+        all_ok = all_ok && sites[i].file != NULL && sites[i].line > 0;
+      TEST( all_ok );
+    }
+#else
+    (void)sites;
+    TEST( cx_site_id( site ) == SIZE_MAX );
+#endif /* __ELF__ */
+  }
+  TEST_FN_END();
+}
+
+static bool test_throw_value( void ) {
+  TEST_FN_BEGIN();
+  unsigned volatile n_catch = 0;
+
+  cx_try {
+    cx_throw_value( TEST_XID_01, -42 );
+  }
+  cx_catch( TEST_XID_01 ) {
+    ++n_catch;
+    cx_exception_t const *const cex = cx_current_exception();
+    TEST( cex->payload_type == CX_PAYLOAD_INT );
+    TEST( cx_payload_int( cex ) == -42 );
+    TEST( cx_payload_string( cex ) == NULL );
+    TEST( cx_user_data() == NULL );
+  }
+
+  cx_try {
+    cx_throw_value( TEST_XID_01, (signed char)-1 );
+  }
+  cx_catch( TEST_XID_01 ) {
+    ++n_catch;
+    TEST( cx_payload_int( cx_current_exception() ) == -1 );
+  }
+
+  cx_try {
+    cx_throw_value( TEST_XID_01, UINT_MAX );
+  }
+  cx_catch( TEST_XID_01 ) {
+    ++n_catch;
+    TEST( cx_payload_int( cx_current_exception() ) == UINT_MAX );
+  }
+
+  cx_try {
+    cx_throw_value( TEST_XID_01, 1.5F );
+  }
+  cx_catch( TEST_XID_01 ) {
+    ++n_catch;
+    cx_exception_t const *const cex = cx_current_exception();
+    TEST( cex->payload_type == CX_PAYLOAD_DOUBLE );
+    TEST( (int)(cx_payload_double( cex ) * 2) == 3 );
+    TEST( cx_payload_int( cex ) == 0 );
+  }
+
+  cx_try {
+    cx_throw_value( TEST_XID_01, "hello" );
+  }
+  cx_catch( TEST_XID_01 ) {
+    ++n_catch;
+    char const *const str = cx_payload_string( cx_current_exception() );
+    if ( TEST( str != NULL ) )
+      TEST( strcmp( str, "hello" ) == 0 );
+  }
+
+  cx_try {
+    test_throw_value_local();
+  }
+  cx_catch( TEST_XID_02 ) {
+    ++n_catch;
+    char const *const str = cx_payload_string( cx_current_exception() );
+    if ( TEST( str != NULL ) )
+      TEST( strlen( str ) == CX_PAYLOAD_SIZE_MAX - 1 );
+  }
+
+  cx_try {
+    char const *const null = NULL;
+    cx_throw_value( TEST_XID_01, null );
+  }
+  cx_catch( TEST_XID_01 ) {
+    ++n_catch;
+    cx_exception_t const *const cex = cx_current_exception();
+    TEST( cex->payload_type == CX_PAYLOAD_NONE );
+    TEST( cx_payload_string( cex ) == NULL );
+  }
+
+  cx_try {
+    cx_throw_value(
+      TEST_XID_01, (struct test_payload){ .line = 1, .col = 2, .name = "a" }
+    );
+  }
+  cx_catch( TEST_XID_01 ) {
+    ++n_catch;
+    cx_exception_t const *const cex = cx_current_exception();
+    struct test_payload const *const tp = cx_payload_ptr( cex );
+    TEST( cex->payload_size == sizeof *tp );
+    if ( TEST( tp != NULL ) ) {
+      TEST( tp->line == 1 );
+      TEST( tp->col == 2 );
+      TEST( strcmp( tp->name, "a" ) == 0 );
+    }
+  }
+
+  TEST( n_catch == 8 );
+  TEST( cx_current_exception() == NULL );
+  TEST_FN_END();
+}
+
+static bool test_throw_value_rethrow( void ) {
+  TEST_FN_BEGIN();
+  unsigned volatile n_inner_catch = 0;
+  unsigned volatile n_outer_catch = 0;
+  cx_exception_ptr_t *volatile xp = NULL;
+  cx_try {
+    cx_try {
+      cx_throw_value( TEST_XID_01, 42 );
+    }
+    cx_catch( TEST_XID_01 ) {
+      ++n_inner_catch;
+      cx_throw();
+    }
+  }
+  cx_catch( TEST_XID_01 ) {
+    ++n_outer_catch;
+    TEST( cx_payload_int( cx_current_exception() ) == 42 );
+    xp = cx_exception_ptr_capture();
+  }
+  if ( TEST( xp != NULL ) ) {
+    TEST( cx_payload_int( cx_exception_ptr_exception( xp ) ) == 42 );
+    cx_try {
+      cx_throw( TEST_XID_02 );
+    }
+    cx_catch( TEST_XID_02 ) {
+      TEST( cx_current_exception()->payload_type == CX_PAYLOAD_NONE );
+    }
+    cx_exception_ptr_release( xp );
+  }
+  TEST( n_inner_catch == 1 );
+  TEST( n_outer_catch == 1 );
+  TEST_FN_END();
+}
+
+static void test_try_catching_function( int xid, unsigned volatile *n_catch ) {
+  cx_try_catching( false, TEST_XID_02 ) {
+    cx_throw( xid );
+  }
+  cx_catch( TEST_XID_02 ) {
+    ++*n_catch;
+  }
+}
+
+static bool test_try_catching_skip( void ) {
+  TEST_FN_BEGIN();
+  unsigned volatile n_inner_catch = 0;
+  unsigned volatile n_outer_catch = 0, n_outer_finally = 0;
+  cx_try {
+    test_try_catching_function( TEST_XID_01, &n_inner_catch );
+  }
+  cx_catch( TEST_XID_01 ) {
+    ++n_outer_catch;
+  }
+  cx_finally {
+    ++n_outer_finally;
+  }
+  TEST( n_inner_catch == 0 );
+  TEST( n_outer_catch == 1 );
+  TEST( n_outer_finally == 1 );
+  TEST( cx_current_exception() == NULL );
+  TEST_FN_END();
+}
+
+static bool test_try_catching_match( void ) {
+  TEST_FN_BEGIN();
+  unsigned volatile n_inner_catch = 0;
+  unsigned volatile n_outer_catch = 0;
+  cx_try {
+    test_try_catching_function( TEST_XID_02, &n_inner_catch );
+  }
+  cx_catch() {
+    ++n_outer_catch;
+  }
+  TEST( n_inner_catch == 1 );
+  TEST( n_outer_catch == 0 );
+  TEST( cx_current_exception() == NULL );
+  TEST_FN_END();
+}
+
+static void test_try_catching_finally_function( int xid,
+                                                unsigned volatile *n_catch,
+                                                unsigned volatile *n_finally ) {
+  cx_try_catching( true, TEST_XID_02 ) {
+    cx_throw( xid );
+  }
+  cx_catch( TEST_XID_02 ) {
+    ++*n_catch;
+  }
+  cx_finally {
+    ++*n_finally;
+  }
+}
+
+static bool test_try_catching_finally( void ) {
+  TEST_FN_BEGIN();
+  unsigned volatile n_inner_catch = 0, n_inner_finally = 0;
+  unsigned volatile n_outer_catch = 0;
+  cx_try {
+    test_try_catching_finally_function(
+      TEST_XID_01, &n_inner_catch, &n_inner_finally
+    );
+  }
+  cx_catch( TEST_XID_01 ) {
+    ++n_outer_catch;
+  }
+  TEST( n_inner_catch == 0 );
+  TEST( n_inner_finally == 1 );
+  TEST( n_outer_catch == 1 );
+  TEST( cx_current_exception() == NULL );
+  TEST_FN_END();
+}
+
+static bool test_catch_any_of( void ) {
+  TEST_FN_BEGIN();
+  unsigned volatile n_catch_1 = 0, n_catch_2 = 0;
+  cx_try {
+    cx_throw( TEST_XID_02 );
+  }
+  cx_catch( TEST_XID_03, TEST_XID_04 ) {
+    ++n_catch_1;
+  }
+  cx_catch( 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, TEST_XID_02 ) {
+    ++n_catch_2;
+  }
+  TEST( n_catch_1 == 0 );
+  TEST( n_catch_2 == 1 );
+  TEST( cx_current_exception() == NULL );
+  TEST_FN_END();
+}
+
+static bool test_catch_range( void ) {
+  TEST_FN_BEGIN();
+  unsigned volatile n_catch_1 = 0, n_catch_2 = 0;
+  cx_try {
+    cx_throw( TEST_XID_02 );
+  }
+  cx_catch_range( TEST_XID_03, TEST_XID_04 ) {
+    ++n_catch_1;
+  }
+  cx_catch_range( TEST_XID_01, TEST_XID_03 ) {
+    ++n_catch_2;
+  }
+  TEST( n_catch_1 == 0 );
+  TEST( n_catch_2 == 1 );
+  TEST( cx_current_exception() == NULL );
+  TEST_FN_END();
+}
+
+static void test_invoke_function( void *ctx ) {
+  int *const pn = ctx;
+  if ( ++*pn > 1 )
+    cx_throw( TEST_XID_01 );
+}
+
+static bool test_invoke( void ) {
+  TEST_FN_BEGIN();
+  int n = 0;
+  cx_exception_t cex;
+  TEST( !cx_invoke( &test_invoke_function, &n, &cex ) );
+  TEST( n == 1 );
+  if ( TEST( cx_invoke( &test_invoke_function, &n, &cex ) ) ) {
+    TEST( cex.thrown_xid == TEST_XID_01 );
+    TEST( cx_exception_file( &cex ) != NULL );
+  }
+  TEST( n == 2 );
+  TEST( cx_invoke( &test_invoke_function, &n, NULL ) );
+  TEST( cx_current_exception() == NULL );
+  TEST_FN_END();
+}
+
+static bool test_noexcept( void ) {
+  TEST_FN_BEGIN();
+  unsigned volatile n_noexcept = 0, n_catch = 0;
+  cx_noexcept {
+    ++n_noexcept;
+    cx_try {
+      cx_throw( TEST_XID_01 );
+    }
+    cx_catch( TEST_XID_01 ) {
+      ++n_catch;
+    }
+  }
+  TEST( n_noexcept == 1 );
+  TEST( n_catch == 1 );
+  TEST( cx_current_exception() == NULL );
+  TEST_FN_END();
+}
+
+#define TEST_ESCAPE_01  1
+#define TEST_ESCAPE_02  2
+
+static void test_escape_search( int depth, void *value,
+                                unsigned volatile *n_finally ) {
+  if ( depth == 0 )
+    cx_escape( TEST_ESCAPE_01, value );
+  cx_try {
+    test_escape_search( depth - 1, value, n_finally );
+  }
+  cx_catch() {
+    TEST( false );
+  }
+  cx_finally {
+    ++*n_finally;
+    TEST( *n_finally <= 3 );            // with fibers, yields mid-escape
+  }
+}
+
+static bool test_escape( void ) {
+  TEST_FN_BEGIN();
+  void *result = NULL;
+  char value;                           // distinct for each fiber
+  unsigned volatile n_inner = 0, n_finally = 0;
+  cx_escape_point( TEST_ESCAPE_01, result ) {
+    void *inner_result = NULL;
+    cx_escape_point( TEST_ESCAPE_02, inner_result ) {
+      ++n_inner;
+      test_escape_search( 3, &value, &n_finally );
+    }
+    TEST( false );
+    (void)inner_result;
+  }
+  TEST( n_inner == 1 );
+  TEST( result == &value );
+  TEST( n_finally == 3 );
+  TEST( cx_current_exception() == NULL );
+
+  // No escape.
+  result = NULL;
+  cx_escape_point( TEST_ESCAPE_01, result ) {
+    ++n_inner;
+  }
+  TEST( n_inner == 2 );
+  TEST( result == NULL );
+
+  // Normal exception through an escape point.
+  unsigned volatile n_catch = 0;
+  cx_try {
+    cx_escape_point( TEST_ESCAPE_01, result ) {
+      cx_throw( TEST_XID_01 );
+    }
+  }
+  cx_catch( TEST_XID_01 ) {
+    ++n_catch;
+  }
+  TEST( n_catch == 1 );
+  TEST( cx_current_exception() == NULL );
+  TEST_FN_END();
+}
+
+/**
+ * A stackless coroutine for test_co_try().
+ */
+struct test_co {
+  unsigned    line;                     ///< Resume point.
+  cx_co_try_t tf;                       ///< Its "try" frame.
+  int         throw_xid;                ///< Exception ID to throw, if any.
+  unsigned    n_catch;                  ///< Number of exceptions caught.
+};
+
+static bool test_co_step( struct test_co *co ) {
+  cx_co_resume( &co->tf ) goto caught;
+  switch ( co->line ) {
+    case 0:
+      cx_co_try( &co->tf ) goto caught;
+      co->line = 1;
+      cx_co_yield( &co->tf );
+      return false;
+    case 1:
+      if ( co->throw_xid != 0 )
+        cx_throw( co->throw_xid );
+      cx_co_try_end( &co->tf );
+  } // switch
+  return true;
+
+caught:
+  if ( cx_co_catch( &co->tf, TEST_XID_01 ) )
+    ++co->n_catch;
+  cx_co_try_end( &co->tf );             // rethrows if not caught
+  return true;
+}
+
+static bool test_co_try( void ) {
+  TEST_FN_BEGIN();
+  struct test_co co = { .tf = CX_CO_TRY_INIT, .throw_xid = TEST_XID_01 };
+  TEST( !test_co_step( &co ) );
+
+  // While the coroutine is suspended, its frame mustn't be in the chain.
+  unsigned volatile n_catch = 0;
+  cx_try {
+    cx_throw( TEST_XID_02 );
+  }
+  cx_catch( TEST_XID_02 ) {
+    ++n_catch;
+  }
+  TEST( n_catch == 1 );
+
+  // After resuming, the coroutine's own handler must catch it.
+  n_catch = 0;
+  cx_try {
+    TEST( test_co_step( &co ) );
+  }
+  cx_catch( TEST_XID_01 ) {
+    ++n_catch;
+  }
+  TEST( co.n_catch == 1 );
+  TEST( n_catch == 0 );
+  TEST( cx_current_exception() == NULL );
+
+  // An exception the coroutine doesn't catch must propagate to the caller.
+  co = (struct test_co){ .tf = CX_CO_TRY_INIT, .throw_xid = TEST_XID_02 };
+  TEST( !test_co_step( &co ) );
+  cx_try {
+    test_co_step( &co );
+  }
+  cx_catch( TEST_XID_02 ) {
+    ++n_catch;
+  }
+  TEST( co.n_catch == 0 );
+  TEST( n_catch == 1 );
+  TEST( cx_current_exception() == NULL );
+  TEST_FN_END();
+}
+
+static bool test_exception_ptr( void ) {
+  TEST_FN_BEGIN();
+  cx_exception_ptr_t *volatile xp = NULL;
+  TEST( cx_exception_ptr_capture() == NULL );
+  int user_data = 42;
+  cx_try {
+    cx_throw( TEST_XID_01, &user_data );
+  }
+  cx_catch() {
+    xp = cx_exception_ptr_capture();
+  }
+  if ( !TEST( xp != NULL ) )
+    return false;
+  TEST( cx_current_exception() == NULL );
+  cx_exception_t const cex = *cx_exception_ptr_exception( xp );
+  TEST( cex.thrown_xid == TEST_XID_01 );
+  cx_exception_ptr_release( cx_exception_ptr_copy( xp ) );
+
+  unsigned volatile n_catch = 0;
+  cx_try {
+    cx_rethrow_ptr( xp );
+  }
+  cx_catch( TEST_XID_01 ) {
+    ++n_catch;
+    cx_exception_t const *const rcex = cx_current_exception();
+    if ( TEST( rcex != NULL ) ) {
+      TEST( rcex->thrown_site == cex.thrown_site );
+      TEST( rcex->user_data == &user_data );
+    }
+  }
+  TEST( n_catch == 1 );
+  TEST_FN_END();
+}
+
+#ifdef HAVE_PTHREAD_H
+static void* test_exception_ptr_thread( void *arg ) {
+  cx_exception_ptr_t **const pxp = arg;
+  cx_try {
+    cx_throw( TEST_XID_02 );
+  }
+  cx_catch() {
+    *pxp = cx_exception_ptr_capture();
+  }
+  return NULL;
+}
 
+static bool test_exception_ptr_thread_join( void ) {
+  TEST_FN_BEGIN();
+  cx_exception_ptr_t *xp = NULL;
+  pthread_t thread;
+  if ( !TEST( pthread_create( &thread, NULL, &test_exception_ptr_thread,
+                              &xp ) == 0 ) ) {
+    return false;
+  }
+  pthread_join( thread, NULL );         // its pool outlives it
+  if ( !TEST( xp != NULL ) )
+    return false;
+  unsigned volatile n_catch = 0;
+  cx_try {
+    cx_rethrow_ptr( xp );
+  }
+  cx_catch( TEST_XID_02 ) {
+    ++n_catch;
+  }
+  TEST( n_catch == 1 );
+  TEST( cx_current_exception() == NULL );
+  TEST_FN_END();
+}
+#endif /* HAVE_PTHREAD_H */
+
+static jmp_buf            test_terminate_env;
+static cx_exception_t     test_terminate_cex;
+
+_Noreturn
+static void test_terminate_handler( cx_exception_t const *cex ) {
+  test_terminate_cex = *cex;
+  longjmp( test_terminate_env, 1 );
+}
+
+static bool test_noexcept_terminates( void ) {
+  TEST_FN_BEGIN();
+  int volatile noexcept_line = 0;
+  cx_set_terminate( &test_terminate_handler );
+  if ( setjmp( test_terminate_env ) == 0 ) {
+    cx_try {
+      noexcept_line = __LINE__ + 1;
+      cx_noexcept {
+        cx_throw( TEST_XID_01 );
+      }
+    }
+    cx_catch( TEST_XID_01 ) {
+      TEST( false );
+    }
+  }
+  else {
+    TEST( test_terminate_cex.thrown_xid == TEST_XID_01 );
+    TEST( cx_exception_line( &test_terminate_cex ) == noexcept_line );
+    TEST( test_terminate_cex.thrown_site->func == NULL );
+  }
+  cx_set_terminate( NULL );
+  cx_impl_try_block_head = NULL;        // abandoned by test_terminate_handler
+  TEST_FN_END();
+}
+
+#if CX_CANCEL_FINALLY && defined(HAVE_PTHREAD_H)
+static atomic_bool  test_cancel_ready;
+static char         test_cancel_order[8];
+static unsigned     test_cancel_n_order;
+
+static void test_cancel_cleanup( void *arg ) {
+  test_cancel_order[ test_cancel_n_order++ ] = (char)(uintptr_t)arg;
+}
+
+static void* test_cancel_thread( void *arg ) {
+  (void)arg;
+  cx_try {
+    pthread_cleanup_push( &test_cancel_cleanup, (void*)(uintptr_t)'c' );
+    cx_try {
+      atomic_store( &test_cancel_ready, true );
+      for (;;)
+        pause();                        // cancellation point
+    }
+    cx_catch() {
+      test_cancel_order[ test_cancel_n_order++ ] = 'x';
+    }
+    cx_finally {
+      test_cancel_order[ test_cancel_n_order++ ] = 'i';
+    }
+    pthread_cleanup_pop( 0 );
+  }
+  cx_catch() {
+    test_cancel_order[ test_cancel_n_order++ ] = 'x';
+  }
+  cx_finally {
+    test_cancel_order[ test_cancel_n_order++ ] = 'o';
+  }
+  return NULL;
+}
+
+static bool test_cancel_finally( void ) {
+  TEST_FN_BEGIN();
+  pthread_t thread;
+  if ( !TEST( pthread_create( &thread, NULL, &test_cancel_thread,
+                              NULL ) == 0 ) ) {
+    return false;
+  }
+  while ( !atomic_load( &test_cancel_ready ) )
+    sched_yield();
+  TEST( pthread_cancel( thread ) == 0 );
+  void *rv = NULL;
+  TEST( pthread_join( thread, &rv ) == 0 );
+  TEST( rv == PTHREAD_CANCELED );
+  // Inner finally, cleanup handler, outer finally; no catches.
+  TEST( test_cancel_n_order == 3 );
+  TEST( strncmp( test_cancel_order, "ico", 3 ) == 0 );
+  TEST_FN_END();
+}
+
+static char         test_exit_order[8];
+static unsigned     test_exit_n_order;
+static int          test_exit_value;
+
+static void* test_exit_thread( void *arg ) {
+  (void)arg;
+  cx_try {
+    cx_try {
+      pthread_exit( &test_exit_value );
+    }
+    cx_catch() {
+      test_exit_order[ test_exit_n_order++ ] = 'x';
+    }
+    cx_finally {
+      test_exit_order[ test_exit_n_order++ ] = 'i';
+    }
+  }
+  cx_catch() {
+    test_exit_order[ test_exit_n_order++ ] = 'x';
+  }
+  cx_finally {
+    test_exit_order[ test_exit_n_order++ ] = 'o';
+  }
+  return NULL;
+}
+
+static bool test_exit_finally( void ) {
+  TEST_FN_BEGIN();
+  pthread_t thread;
+  if ( !TEST( pthread_create( &thread, NULL, &test_exit_thread,
+                              NULL ) == 0 ) ) {
+    return false;
+  }
+  void *rv = NULL;
+  TEST( pthread_join( thread, &rv ) == 0 );
+  TEST( rv == &test_exit_value );       // not replaced by PTHREAD_CANCELED
+  TEST( test_exit_n_order == 2 );
+  TEST( strncmp( test_exit_order, "io", 2 ) == 0 );
+  TEST_FN_END();
+}
+#endif /* CX_CANCEL_FINALLY && HAVE_PTHREAD_H */
+
+/**
+ * Runs the tests that can run concurrently in fibers on the same thread, i.e.,
+ * those that don't change per-thread state across a call to #TEST().
+ *
+ * @param arg Not used.
+ */
+static void test_fiber_safe( void *arg ) {
+  (void)arg;
   test_no_throw();
   test_throw_catch_1();
   test_throw_catch_2();
   test_throw_catch_all();
   test_throw_from_a_called_function();
+#if CX_JMP_BACKEND == CX_JMP_BACKEND_UNWIND
+  test_unwind_cleanups();
+#endif /* CX_JMP_BACKEND == CX_JMP_BACKEND_UNWIND */
   test_custom_xid_matcher();
+  test_try_with_matcher();
   test_throw_from_nested_catch();
   test_rethrow_in_catch();
   test_throw_with_user_data();
+  test_throw_nested();
+  test_throw_nested_deep();
+  test_throwf();
+  test_context();
+  test_sites();
+  test_throw_value();
+  test_throw_value_rethrow();
+  test_try_catching_skip();
+  test_try_catching_match();
+  test_try_catching_finally();
+  test_catch_any_of();
+  test_catch_range();
+  test_invoke();
+  test_noexcept();
+  test_escape();
+  test_co_try();
+  test_exception_ptr();
+#ifdef HAVE_PTHREAD_H
+  test_exception_ptr_thread_join();
+#endif /* HAVE_PTHREAD_H */
+}
+
+int main( int argc, char const *argv[] ) {
+  (void)argc;
+  me = argv[0];
+
+#ifdef TEST_FIBERS
+  for ( unsigned i = 0; i < TEST_N_FIBERS; ++i )
+    fiber_spawn( &test_fiber_safe, NULL );
+  fiber_run();
+#else
+  test_fiber_safe( NULL );
+#endif /* TEST_FIBERS */
+
+  test_thread_xid_matcher();
+#if CX_CANCEL_FINALLY && defined(HAVE_PTHREAD_H)
+  test_cancel_finally();
+  test_exit_finally();
+#endif /* CX_CANCEL_FINALLY && HAVE_PTHREAD_H */
+
+  test_noexcept_terminates();           // must be last
 
   printf( "%u failures\n", test_failures );
   exit( test_failures > 0 ? EX_SOFTWARE : EX_OK );
@@ -0,0 +1,125 @@
+/*
+**      C Exception -- Exception Library for C
+**      src/cx_cancel.c
+**
+**      Copyright (C) 2023-2024  Paul J. Lucas
+**
+**      This program is free software: you can redistribute it and/or modify
+**      it under the terms of the GNU General Public License as published by
+**      the Free Software Foundation, either version 3 of the License, or
+**      (at your option) any later version.
+**
+**      This program is distributed in the hope that it will be useful,
+**      but WITHOUT ANY WARRANTY; without even the implied warranty of
+**      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**      GNU General Public License for more details.
+**
+**      You should have received a copy of the GNU General Public License
+**      along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * Defines functions for cooperative cancellation.
+ */
+
+// local
+#include "config.h"                     /* must go first */
+#include "cx_cancel.h"
+
+// standard
+#include <assert.h>
+#include <stddef.h>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif /* HAVE_PTHREAD_H */
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @addtogroup cx-cancel-group
+ * @{
+ */
+
+#ifdef HAVE_PTHREAD_H
+/**
+ * Guards the \ref cx_cancel_token::parent "parent", \ref
+ * cx_cancel_token::first_child "first_child", and \ref
+ * cx_cancel_token::next_sibling "next_sibling" members of all tokens.
+ *
+ * @remarks Only initializing, cleaning up, and cancelling tokens lock it, never
+ * #cx_check_cancel, so a single mutex suffices.
+ */
+static pthread_mutex_t cx_impl_cancel_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+# define CX_IMPL_CANCEL_LOCK()    pthread_mutex_lock( &cx_impl_cancel_mutex )
+# define CX_IMPL_CANCEL_UNLOCK()  pthread_mutex_unlock( &cx_impl_cancel_mutex )
+#else
+# define CX_IMPL_CANCEL_LOCK()    ((void)0)
+# define CX_IMPL_CANCEL_UNLOCK()  ((void)0)
+#endif /* HAVE_PTHREAD_H */
+
+////////// local functions ////////////////////////////////////////////////////
+
+/**
+ * Cancels \a token and all of its descendants.
+ *
+ * @param token The \ref cx_cancel_token_t to cancel.
+ *
+ * @warning #cx_impl_cancel_mutex must be locked.
+ */
+static void cx_impl_cancel_tree( cx_cancel_token_t *token ) {
+  if ( atomic_exchange_explicit( &token->cancelled, true,
+                                 memory_order_release ) ) {
+    return;                             // already cancelled, hence children
+  }
+  for ( cx_cancel_token_t *child = token->first_child; child != NULL;
+        child = child->next_sibling ) {
+    cx_impl_cancel_tree( child );
+  } // for
+}
+
+////////// extern functions ///////////////////////////////////////////////////
+
+void cx_cancel_request( cx_cancel_token_t *token ) {
+  assert( token != NULL );
+  if ( cx_cancel_requested( token ) )
+    return;
+  CX_IMPL_CANCEL_LOCK();
+  cx_impl_cancel_tree( token );
+  CX_IMPL_CANCEL_UNLOCK();
+}
+
+void cx_cancel_token_cleanup( cx_cancel_token_t *token ) {
+  assert( token != NULL );
+  CX_IMPL_CANCEL_LOCK();
+  assert( token->first_child == NULL );
+  if ( token->parent != NULL ) {
+    cx_cancel_token_t **pnext = &token->parent->first_child;
+    while ( *pnext != token )
+      pnext = &(*pnext)->next_sibling;
+    *pnext = token->next_sibling;
+    token->parent = token->next_sibling = NULL;
+  }
+  CX_IMPL_CANCEL_UNLOCK();
+}
+
+void cx_cancel_token_init( cx_cancel_token_t *token,
+                           cx_cancel_token_t *parent ) {
+  assert( token != NULL );
+  *token = (cx_cancel_token_t){ .parent = parent };
+  if ( parent == NULL ) {
+    atomic_init( &token->cancelled, false );
+    return;
+  }
+  CX_IMPL_CANCEL_LOCK();
+  atomic_init( &token->cancelled, cx_cancel_requested( parent ) );
+  token->next_sibling = parent->first_child;
+  parent->first_child = token;
+  CX_IMPL_CANCEL_UNLOCK();
+}
+
+/** @} */
+
+///////////////////////////////////////////////////////////////////////////////
+/* vim:set et sw=2 ts=2: */
@@ -0,0 +1,178 @@
+/*
+**      C Exception -- Exception Library for C
+**      src/cx_cancel.h
+**
+**      Copyright (C) 2023-2024  Paul J. Lucas
+**
+**      This program is free software: you can redistribute it and/or modify
+**      it under the terms of the GNU General Public License as published by
+**      the Free Software Foundation, either version 3 of the License, or
+**      (at your option) any later version.
+**
+**      This program is distributed in the hope that it will be useful,
+**      but WITHOUT ANY WARRANTY; without even the implied warranty of
+**      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**      GNU General Public License for more details.
+**
+**      You should have received a copy of the GNU General Public License
+**      along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CX_CANCEL_H
+#define CX_CANCEL_H
+
+/**
+ * @file
+ * Declares types, macros, and functions for cooperative cancellation where
+ * cancellation is delivered as an exception.
+ */
+
+// local
+#include "c_exception.h"
+
+// standard
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @defgroup cx-cancel-group Cancellation Tokens
+ * Types, macros, and functions for cooperative cancellation.
+ *
+ * @remarks
+ * @parblock
+ * A long-running job periodically calls #cx_check_cancel at points where it's
+ * safe to stop.  When another thread calls cx_cancel_request() for the job's
+ * \ref cx_cancel_token, the next #cx_check_cancel throws #CX_XID_CANCELLED.
+ * Any #cx_finally blocks between it and the #cx_catch for it do cleanup.  For
+ * example:
+ *  ```c
+ *  void copy_file( FILE *from, FILE *to, cx_cancel_token_t *token ) {
+ *    char buf[ 4096 ];
+ *    size_t n;
+ *    while ( (n = fread( buf, 1, sizeof buf, from )) > 0 ) {
+ *      cx_check_cancel( token );
+ *      fwrite( buf, 1, n, to );
+ *    }
+ *  }
+ *  ```
+ *
+ * Tokens can form trees: cancelling a token also cancels all of its
+ * descendants.  Hence, a job that starts sub-jobs can give each its own child
+ * token so each can be cancelled individually or all of them at once.
+ *
+ * A #cx_check_cancel for a token that hasn't been cancelled costs a single
+ * relaxed atomic load.
+ * @endparblock
+ *
+ * @{
+ */
+
+/**
+ * A cancellation token.
+ *
+ * @sa cx_cancel_token_init()
+ * @sa #CX_CANCEL_TOKEN_INIT
+ */
+typedef struct cx_cancel_token cx_cancel_token_t;
+
+/**
+ * A cancellation token.
+ *
+ * @remarks Its members are private.
+ */
+struct cx_cancel_token {
+  /**
+   * Has this token (or any of its ancestors) been cancelled?
+   */
+  atomic_bool         cancelled;
+
+  cx_cancel_token_t  *parent;           ///< Parent token, if any.
+  cx_cancel_token_t  *first_child;      ///< First child token, if any.
+  cx_cancel_token_t  *next_sibling;     ///< Next sibling token, if any.
+};
+
+/**
+ * Initializer for a \ref cx_cancel_token_t that has no parent.
+ *
+ * @sa cx_cancel_token_init()
+ */
+#define CX_CANCEL_TOKEN_INIT      { .cancelled = false }
+
+/**
+ * Throws #CX_XID_CANCELLED if \a TOKEN has been cancelled.
+ *
+ * @param TOKEN A pointer to the \ref cx_cancel_token_t to check.
+ *
+ * @sa cx_cancel_request()
+ * @sa cx_cancel_requested()
+ */
+#define cx_check_cancel(TOKEN)                  \
+  do {                                          \
+    if ( cx_cancel_requested( (TOKEN) ) )       \
+      cx_throw( CX_XID_CANCELLED );             \
+  } while (0)
+
+/**
+ * Cancels \a token and all of its descendants.
+ *
+ * @param token The \ref cx_cancel_token_t to cancel.
+ *
+ * @note It may be called from any thread.  Cancelling a token that's already
+ * cancelled does nothing.
+ *
+ * @sa #cx_check_cancel
+ */
+void cx_cancel_request( cx_cancel_token_t *token );
+
+/**
+ * Checks whether \a token has been cancelled.
+ *
+ * @param token The \ref cx_cancel_token_t to check.
+ * @return Returns `true` only if \a token has been cancelled.
+ *
+ * @sa #cx_check_cancel
+ */
+static inline bool cx_cancel_requested( cx_cancel_token_t const *token ) {
+  return atomic_load_explicit( &token->cancelled, memory_order_relaxed );
+}
+
+/**
+ * Cleans up \a token, removing it from its parent, if any.
+ *
+ * @param token The \ref cx_cancel_token_t to clean up.
+ *
+ * @warning All of \a token's children must have been cleaned up first.
+ *
+ * @sa cx_cancel_token_init()
+ */
+void cx_cancel_token_cleanup( cx_cancel_token_t *token );
+
+/**
+ * Initializes \a token.
+ *
+ * @param token The \ref cx_cancel_token_t to initialize.
+ * @param parent The parent token or NULL for none.  If \a parent has already
+ * been cancelled, so is \a token.
+ *
+ * @sa cx_cancel_token_cleanup()
+ * @sa #CX_CANCEL_TOKEN_INIT
+ */
+void cx_cancel_token_init( cx_cancel_token_t *token,
+                           cx_cancel_token_t *parent );
+
+/** @} */
+
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef __cplusplus
+} // extern "C"
+#endif /* __cplusplus */
+
+#endif /* CX_CANCEL_H */
+/* vim:set et sw=2 ts=2: */
@@ -0,0 +1,188 @@
+/*
+**      C Exception -- Exception Library for C
+**      src/cx_cancel_test.c
+**
+**      Copyright (C) 2023-2024  Paul J. Lucas
+**
+**      This program is free software: you can redistribute it and/or modify
+**      it under the terms of the GNU General Public License as published by
+**      the Free Software Foundation, either version 3 of the License, or
+**      (at your option) any later version.
+**
+**      This program is distributed in the hope that it will be useful,
+**      but WITHOUT ANY WARRANTY; without even the implied warranty of
+**      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**      GNU General Public License for more details.
+**
+**      You should have received a copy of the GNU General Public License
+**      along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * Tests cancellation tokens.
+ */
+
+// local
+#include "config.h"                     /* must go first */
+#include "c_exception.h"
+#include "cx_cancel.h"
+#include "unit_test.h"
+
+// standard
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sysexits.h>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif /* HAVE_PTHREAD_H */
+
+///////////////////////////////////////////////////////////////////////////////
+
+// extern variables
+char const   *me;
+
+// local variables
+static unsigned test_failures;
+
+////////// local functions ////////////////////////////////////////////////////
+
+/**
+ * Checks whether \a token has been cancelled via #cx_check_cancel.
+ *
+ * @param token The \ref cx_cancel_token_t to check.
+ * @return Returns `true` only if #CX_XID_CANCELLED was thrown.
+ */
+static bool test_check( cx_cancel_token_t *token ) {
+  bool volatile cancelled = false;
+  cx_try {
+    cx_check_cancel( token );
+  }
+  cx_catch( CX_XID_CANCELLED ) {
+    cancelled = true;
+  }
+  return cancelled;
+}
+
+#ifdef HAVE_PTHREAD_H
+/**
+ * Loops until \a arg is cancelled.
+ *
+ * @param arg A pointer to the \ref cx_cancel_token_t.
+ * @return Returns \a arg only if #CX_XID_CANCELLED was caught.
+ */
+static void* test_cancel_thread_main( void *arg ) {
+  static atomic_ulong n_iterations;
+  void *volatile rv = NULL;
+  cx_try {
+    for (;;) {
+      cx_check_cancel( (cx_cancel_token_t*)arg );
+      atomic_fetch_add_explicit( &n_iterations, 1, memory_order_relaxed );
+    } // for
+  }
+  cx_catch( CX_XID_CANCELLED ) {
+    rv = arg;
+  }
+  return rv;
+}
+#endif /* HAVE_PTHREAD_H */
+
+///////////////////////////////////////////////////////////////////////////////
+
+static bool test_cancel( void ) {
+  TEST_FN_BEGIN();
+  cx_cancel_token_t token = CX_CANCEL_TOKEN_INIT;
+  TEST( !cx_cancel_requested( &token ) );
+  TEST( !test_check( &token ) );
+
+  cx_cancel_request( &token );
+  TEST( cx_cancel_requested( &token ) );
+
+  unsigned volatile n_finally = 0;
+  bool volatile caught = false;
+  cx_try {
+    cx_try {
+      cx_check_cancel( &token );
+      TEST( false );
+    }
+    cx_finally {
+      ++n_finally;
+    }
+  }
+  cx_catch( CX_XID_CANCELLED ) {
+    caught = true;
+  }
+  TEST( caught );
+  TEST( n_finally == 1 );
+  TEST( cx_current_exception() == NULL );
+
+  cx_cancel_request( &token );          // already cancelled: does nothing
+  TEST( test_check( &token ) );
+  cx_cancel_token_cleanup( &token );
+  TEST_FN_END();
+}
+
+#ifdef HAVE_PTHREAD_H
+static bool test_cancel_thread( void ) {
+  TEST_FN_BEGIN();
+  cx_cancel_token_t token;
+  cx_cancel_token_init( &token, NULL );
+  pthread_t thread;
+  TEST( pthread_create( &thread, NULL, &test_cancel_thread_main, &token ) == 0 );
+  cx_cancel_request( &token );
+  void *rv = NULL;
+  TEST( pthread_join( thread, &rv ) == 0 );
+  TEST( rv == &token );
+  cx_cancel_token_cleanup( &token );
+  TEST_FN_END();
+}
+#endif /* HAVE_PTHREAD_H */
+
+static bool test_cancel_tree( void ) {
+  TEST_FN_BEGIN();
+  cx_cancel_token_t root, child_1, child_2, grandchild;
+  cx_cancel_token_init( &root, NULL );
+  cx_cancel_token_init( &child_1, &root );
+  cx_cancel_token_init( &child_2, &root );
+  cx_cancel_token_init( &grandchild, &child_1 );
+
+  cx_cancel_request( &child_1 );
+  TEST( !test_check( &root ) );
+  TEST( test_check( &child_1 ) );
+  TEST( !test_check( &child_2 ) );
+  TEST( test_check( &grandchild ) );
+
+  cx_cancel_request( &root );
+  TEST( test_check( &root ) );
+  TEST( test_check( &child_2 ) );
+
+  cx_cancel_token_t late_child;
+  cx_cancel_token_init( &late_child, &root );
+  TEST( test_check( &late_child ) );
+
+  cx_cancel_token_cleanup( &late_child );
+  cx_cancel_token_cleanup( &grandchild );
+  cx_cancel_token_cleanup( &child_2 );
+  cx_cancel_token_cleanup( &child_1 );
+  TEST( root.first_child == NULL );
+  cx_cancel_token_cleanup( &root );
+  TEST_FN_END();
+}
+
+int main( int argc, char const *argv[] ) {
+  (void)argc;
+  me = argv[0];
+
+  test_cancel();
+#ifdef HAVE_PTHREAD_H
+  test_cancel_thread();
+#endif /* HAVE_PTHREAD_H */
+  test_cancel_tree();
+
+  printf( "%u failures\n", test_failures );
+  exit( test_failures > 0 ? EX_SOFTWARE : EX_OK );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/* vim:set et sw=2 ts=2: */
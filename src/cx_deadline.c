@@ -0,0 +1,293 @@
+/*
+**      C Exception -- Exception Library for C
+**      src/cx_deadline.c
+**
+**      Copyright (C) 2023-2024  Paul J. Lucas
+**
+**      This program is free software: you can redistribute it and/or modify
+**      it under the terms of the GNU General Public License as published by
+**      the Free Software Foundation, either version 3 of the License, or
+**      (at your option) any later version.
+**
+**      This program is distributed in the hope that it will be useful,
+**      but WITHOUT ANY WARRANTY; without even the implied warranty of
+**      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**      GNU General Public License for more details.
+**
+**      You should have received a copy of the GNU General Public License
+**      along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * Defines functions for "try" blocks with a deadline.
+ */
+
+// local
+#include "config.h"                     /* must go first */
+#include "cx_deadline.h"
+
+// standard
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @addtogroup cx-deadline-group
+ * @{
+ */
+
+#ifndef sigev_notify_thread_id
+# define sigev_notify_thread_id   _sigev_un._tid
+#endif /* sigev_notify_thread_id */
+
+/**
+ * The signal delivered by each thread's timer.
+ */
+#define CX_IMPL_DEADLINE_SIGNAL   SIGRTMIN
+
+/**
+ * How long to wait before trying again to throw #CX_XID_TIMEOUT when a
+ * deadline passes within a region that isn't safe to interrupt.
+ */
+#define CX_IMPL_DEADLINE_RETRY_NS 1000000u  /* 1 ms */
+
+// local functions
+static void cx_impl_deadline_thread_exit( void* );
+
+/**
+ * This thread's innermost open deadline, if any.
+ */
+static CX_IMPL_THREAD_LOCAL cx_impl_deadline_t *cx_impl_deadline_top;
+
+/**
+ * The deadline this thread's timer is armed for or 0 if disarmed.
+ *
+ * @remarks It's `volatile` since it's also set by
+ * cx_impl_deadline_handler().
+ */
+static CX_IMPL_THREAD_LOCAL uint64_t volatile cx_impl_deadline_armed_ns;
+
+/**
+ * This thread's timer.
+ */
+static CX_IMPL_THREAD_LOCAL timer_t cx_impl_deadline_timer;
+
+/**
+ * Has \ref cx_impl_deadline_timer been created?
+ */
+static CX_IMPL_THREAD_LOCAL bool cx_impl_deadline_timer_created;
+
+/**
+ * Key used only to delete a thread's \ref cx_impl_deadline_timer when the
+ * thread exits.
+ */
+static pthread_key_t  cx_impl_deadline_key;
+
+/**
+ * Used to install cx_impl_deadline_handler() and create \ref
+ * cx_impl_deadline_key only once.
+ */
+static pthread_once_t cx_impl_deadline_once = PTHREAD_ONCE_INIT;
+
+////////// local functions ////////////////////////////////////////////////////
+
+/**
+ * Arms this thread's timer to go off at \a expiry_ns.
+ *
+ * @param expiry_ns The `CLOCK_MONOTONIC` time in nanoseconds or 0 to disarm
+ * it.
+ *
+ * @note It's async-signal-safe.
+ */
+static void cx_impl_deadline_arm( uint64_t expiry_ns ) {
+  cx_impl_deadline_armed_ns = expiry_ns;
+  struct itimerspec const its = {
+    .it_value = {
+      .tv_sec  = (time_t)(expiry_ns / 1000000000u),
+      .tv_nsec = (long)(expiry_ns % 1000000000u)
+    }
+  };
+  timer_settime( cx_impl_deadline_timer, TIMER_ABSTIME, &its, NULL );
+}
+
+/**
+ * Gets the current `CLOCK_MONOTONIC` time.
+ *
+ * @return Returns said time in nanoseconds.
+ *
+ * @note It's async-signal-safe.
+ */
+static uint64_t cx_impl_deadline_now( void ) {
+  struct timespec now;
+  clock_gettime( CLOCK_MONOTONIC, &now );
+  return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+/**
+ * Handles #CX_IMPL_DEADLINE_SIGNAL: if a deadline of an open
+ * #cx_try_deadline block of this thread has passed, throws #CX_XID_TIMEOUT if
+ * it's safe to; otherwise re-arms the timer for the earliest deadline, if
+ * any.
+ *
+ * @param sig The signal.
+ */
+static void cx_impl_deadline_handler( int sig ) {
+  cx_impl_deadline_armed_ns = 0;
+  if ( cx_impl_deadline_top == NULL )
+    return;                             // stale: the blocks have all exited
+
+  int const saved_errno = errno;
+
+  uint64_t const now_ns = cx_impl_deadline_now();
+  uint64_t rearm_ns = 0;
+  cx_impl_deadline_t const *expired = NULL;
+
+  for ( cx_impl_deadline_t const *dl = cx_impl_deadline_top; dl != NULL;
+        dl = dl->prev ) {
+    if ( dl->tb->state != CX_IMPL_TRY )
+      continue;                         // try code has finished
+    if ( dl->expiry_ns <= now_ns ) {
+      expired = dl;
+      break;
+    }
+    if ( rearm_ns == 0 || dl->expiry_ns < rearm_ns )
+      rearm_ns = dl->expiry_ns;
+  } // for
+
+  if ( expired != NULL ) {
+    //
+    // Whether or not it's safe to throw now, re-arm the timer to try again:
+    // if it's not safe, the next attempt may be; if it is, but the exception
+    // is caught within the block, it's thrown again.
+    //
+    rearm_ns = now_ns + CX_IMPL_DEADLINE_RETRY_NS;
+    cx_impl_deadline_arm( rearm_ns );
+
+    cx_impl_try_block_t const *const head = cx_impl_try_block_head;
+    if ( cx_impl_busy ) {
+      //
+      // The library is in the middle of updating its state: have it raise
+      // the signal again as soon as it's done.
+      //
+      cx_impl_busy_deferred_sig = sig;
+    }
+    else if ( head != NULL && (head->state == CX_IMPL_TRY ||
+                               head->state == CX_IMPL_ESCAPE ||
+                               head->state == CX_IMPL_SCOPE ||
+                               head->state == CX_IMPL_CONTEXT) ) {
+      sigset_t set;
+      sigemptyset( &set );
+      sigaddset( &set, sig );
+      pthread_sigmask( SIG_UNBLOCK, &set, NULL );
+      errno = saved_errno;
+      cx_impl_throw( expired->site, CX_XID_TIMEOUT, NULL );
+    }
+  }
+  else if ( rearm_ns != 0 ) {
+    cx_impl_deadline_arm( rearm_ns );
+  }
+
+  errno = saved_errno;
+}
+
+/**
+ * Installs cx_impl_deadline_handler() and creates \ref cx_impl_deadline_key.
+ */
+static void cx_impl_deadline_init( void ) {
+  struct sigaction sa = {
+    .sa_handler = &cx_impl_deadline_handler,
+    .sa_flags = SA_RESTART
+  };
+  sigemptyset( &sa.sa_mask );
+  if ( sigaction( CX_IMPL_DEADLINE_SIGNAL, &sa, NULL ) != 0 ) {
+    perror( "sigaction()" );
+    abort();
+  }
+  if ( pthread_key_create( &cx_impl_deadline_key,
+                           &cx_impl_deadline_thread_exit ) != 0 ) {
+    perror( "pthread_key_create()" );
+    abort();
+  }
+}
+
+/**
+ * Deletes the calling thread's \ref cx_impl_deadline_timer.
+ *
+ * @param arg Not used.
+ */
+static void cx_impl_deadline_thread_exit( void *arg ) {
+  (void)arg;
+  timer_delete( cx_impl_deadline_timer );
+  cx_impl_deadline_timer_created = false;
+}
+
+/**
+ * Creates this thread's \ref cx_impl_deadline_timer.
+ */
+static void cx_impl_deadline_timer_create( void ) {
+  pthread_once( &cx_impl_deadline_once, &cx_impl_deadline_init );
+  struct sigevent sev = {
+    .sigev_notify = SIGEV_THREAD_ID,
+    .sigev_signo = CX_IMPL_DEADLINE_SIGNAL
+  };
+  sev.sigev_notify_thread_id = gettid();
+  if ( timer_create( CLOCK_MONOTONIC, &sev, &cx_impl_deadline_timer ) != 0 ) {
+    perror( "timer_create()" );
+    abort();
+  }
+  // The value only needs to be non-NULL for the destructor to be called.
+  pthread_setspecific( cx_impl_deadline_key, &cx_impl_deadline_timer );
+  cx_impl_deadline_timer_created = true;
+}
+
+////////// extern functions ///////////////////////////////////////////////////
+
+bool cx_impl_deadline_condition( cx_impl_deadline_t *dl,
+                                 cx_impl_try_block_t *tb ) {
+  assert( dl != NULL );
+  assert( tb != NULL );
+
+  switch ( tb->state ) {
+    case CX_IMPL_INIT:
+      if ( !cx_impl_deadline_timer_created )
+        cx_impl_deadline_timer_create();
+      dl->expiry_ns = cx_impl_deadline_now() + dl->timeout_ns;
+      dl->tb = tb;
+      dl->prev = cx_impl_deadline_top;
+      // Ensure dl is complete before cx_impl_deadline_handler() can see it.
+      atomic_signal_fence( memory_order_release );
+      cx_impl_deadline_top = dl;
+      if ( cx_impl_deadline_armed_ns == 0 ||
+           dl->expiry_ns < cx_impl_deadline_armed_ns ) {
+        cx_impl_deadline_arm( dl->expiry_ns );
+      }
+      break;
+    case CX_IMPL_FINALLY:
+      assert( cx_impl_deadline_top == dl );
+      //
+      // Pop before cx_impl_try_condition() possibly rethrows.  The timer is
+      // deliberately left armed: disarming it would cost a system call every
+      // time; instead, cx_impl_deadline_handler() ignores a stale expiry.
+      //
+      cx_impl_deadline_top = dl->prev;
+      break;
+    default:
+      break;
+  } // switch
+
+  return cx_impl_try_condition( tb );
+}
+
+/** @} */
+
+///////////////////////////////////////////////////////////////////////////////
+/* vim:set et sw=2 ts=2: */
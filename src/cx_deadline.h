@@ -0,0 +1,194 @@
+/*
+**      C Exception -- Exception Library for C
+**      src/cx_deadline.h
+**
+**      Copyright (C) 2023-2024  Paul J. Lucas
+**
+**      This program is free software: you can redistribute it and/or modify
+**      it under the terms of the GNU General Public License as published by
+**      the Free Software Foundation, either version 3 of the License, or
+**      (at your option) any later version.
+**
+**      This program is distributed in the hope that it will be useful,
+**      but WITHOUT ANY WARRANTY; without even the implied warranty of
+**      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**      GNU General Public License for more details.
+**
+**      You should have received a copy of the GNU General Public License
+**      along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CX_DEADLINE_H
+#define CX_DEADLINE_H
+
+/**
+ * @file
+ * Declares macros and functions for "try" blocks with a deadline: if the
+ * deadline passes while the block's code is still running, #CX_XID_TIMEOUT
+ * is thrown preemptively via a timer signal.
+ */
+
+// local
+#include "c_exception.h"
+
+// standard
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef CX_IMPL_SITE
+# error "cx_try_deadline requires GCC, Clang, or C23."
+#endif /* CX_IMPL_SITE */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @defgroup cx-deadline-group Deadlines
+ * Macros and functions for "try" blocks with a deadline.
+ *
+ * @remarks
+ * @parblock
+ * A #cx_try_deadline block is like a #cx_try block except that, if its code
+ * is still running when its deadline passes, #CX_XID_TIMEOUT is thrown from
+ * wherever the code happens to be, even within a function that never checks
+ * for cancellation.  For example:
+ *  ```c
+ *  cx_try_deadline( 50 * 1000000 ) {   // 50 ms
+ *    result = third_party_solve( problem );
+ *  }
+ *  cx_catch( CX_XID_TIMEOUT ) {
+ *    result = NULL;
+ *  }
+ *  ```
+ *
+ * Each thread has its own POSIX timer that delivers a real-time signal to
+ * only that thread.  The timer is created the first time the thread enters a
+ * #cx_try_deadline block and is reused thereafter.  Entering a block re-arms
+ * the timer only if the block's deadline is earlier than the one it's already
+ * armed for and exiting a block doesn't touch it, so repeatedly entering
+ * blocks with the same timeout makes no system calls.  When the timer goes off
+ * for a block that has since exited, the signal is ignored and the timer is
+ * re-armed only for the earliest deadline of the open blocks, if any.
+ * @endparblock
+ *
+ * @par Regions safe to interrupt
+ * @parblock
+ * An exception thrown by a signal handler abandons whatever the thread was
+ * doing.  Hence, #CX_XID_TIMEOUT is thrown only when the innermost open block
+ * is either a #cx_try block whose _try_ code is running, a #cx_escape_point,
+ * or a #cx_try_with_matcher.  In particular, it's _never_ thrown:
+ *
+ *  + Within a #cx_catch or #cx_finally block.
+ *  + Within a #cx_noexcept block (unless within a #cx_try block nested
+ *    inside it).
+ *  + While this library is updating its own per-thread state, e.g., the
+ *    current exception while throwing.  Such updates either are single stores
+ *    or are within regions the library marks as busy.
+ *
+ * When the deadline passes within a busy region, #CX_XID_TIMEOUT is thrown
+ * as soon as the region ends; within any other such region, it's thrown
+ * shortly after the region ends.
+ *
+ * Everything else is interruptible, so code within a #cx_try_deadline block
+ * must be _async-signal-safe_: if it calls any function that isn't listed in
+ * signal-safety(7), e.g., `malloc()`, `printf()`, or `pthread_mutex_lock()`,
+ * either that call must be within a #cx_noexcept block:
+ *  ```c
+ *  cx_try_deadline( timeout_ns ) {
+ *    for ( size_t i = 0; i < n; ++i ) {
+ *      crunch( &data[i] );             // pure computation: interruptible
+ *      cx_noexcept {
+ *        log_progress( i );            // calls printf(): not interruptible
+ *      }
+ *    }
+ *  }
+ *  ```
+ * or it must otherwise be acceptable for the call never to return, e.g.,
+ * because the process exits after the timeout is caught.
+ * @endparblock
+ *
+ * @note The signal used is `SIGRTMIN`.  Its handler is installed the first
+ * time any thread enters a #cx_try_deadline block, replacing any existing
+ * handler for it.  It's installed with `SA_RESTART`, but a system call that's
+ * never restarted, e.g., `nanosleep()`, made after a block has exited may
+ * still fail once with `EINTR` when the timer goes off for that block.
+ *
+ * @warning Within a #cx_try_deadline block, you must _never_ use
+ * cx_cancel_try(), nor call cx_state_swap() to switch fibers.
+ *
+ * @{
+ */
+
+/**
+ * Begins a "try" block with a deadline: if the code within the block (not
+ * including any #cx_catch or #cx_finally blocks) is still running \a NS
+ * nanoseconds after the block is entered, #CX_XID_TIMEOUT is thrown.
+ *
+ * @remarks Like #cx_try, it may be followed by #cx_catch and #cx_finally
+ * blocks.
+ *
+ * @param NS The timeout in nanoseconds.
+ *
+ * @note Blocks may be nested: an inner block's deadline is effectively the
+ * earlier of its own and all of its enclosing blocks' deadlines.
+ *
+ * @note Requires GCC, Clang, or C23.
+ *
+ * @sa #cx_try
+ * @sa #CX_XID_TIMEOUT
+ */
+#define cx_try_deadline(NS)                                           \
+  for ( cx_impl_deadline_t cx_dl =                                    \
+          { .timeout_ns = (NS), .site = CX_IMPL_SITE() },             \
+          *volatile cx_dlp = &cx_dl;                                  \
+        cx_dlp != NULL; cx_dlp = NULL )                               \
+  for ( cx_impl_try_block_t cx_tb CX_IMPL_TRY_CLEANUP =               \
+          { .try_file = __FILE__, .try_line = __LINE__ };             \
+        cx_impl_deadline_condition( &cx_dl, &cx_tb ); )               \
+    if ( cx_tb.state != CX_IMPL_FINALLY )                             \
+      if ( CX_IMPL_SETJMP( cx_tb.env ) == 0 )
+
+/** @} */
+
+////////// implementation /////////////////////////////////////////////////////
+
+/// @cond DOXYGEN_IGNORE
+
+/**
+ * The deadline of a #cx_try_deadline block.
+ */
+struct cx_impl_deadline {
+  uint64_t                  timeout_ns; ///< Timeout in nanoseconds.
+  uint64_t                  expiry_ns;  ///< Deadline (`CLOCK_MONOTONIC`).
+  cx_impl_try_block_t      *tb;         ///< The "try" block it's for.
+  cx_site_t const          *site;       ///< Whence #CX_XID_TIMEOUT is thrown.
+  struct cx_impl_deadline  *prev;       ///< Enclosing deadline, if any.
+};
+typedef struct cx_impl_deadline cx_impl_deadline_t;
+
+/**
+ * Calls cx_impl_try_condition() for \a tb, additionally pushing \a dl when
+ * \a tb is entered and popping it when \a tb is exited.
+ *
+ * @param dl A pointer to the \ref cx_impl_deadline for \a tb.
+ * @param tb A pointer to the \ref cx_impl_try_block of the #cx_try_deadline.
+ * @return Returns what cx_impl_try_condition() returns.
+ *
+ * @warning This function is called by the implementation only.
+ */
+bool cx_impl_deadline_condition( cx_impl_deadline_t *dl,
+                                 cx_impl_try_block_t *tb );
+
+/// @endcond
+
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef __cplusplus
+} // extern "C"
+#endif /* __cplusplus */
+
+#endif /* CX_DEADLINE_H */
+/* vim:set et sw=2 ts=2: */
@@ -0,0 +1,242 @@
+/*
+**      C Exception -- Exception Library for C
+**      src/cx_deadline_test.c
+**
+**      Copyright (C) 2023-2024  Paul J. Lucas
+**
+**      This program is free software: you can redistribute it and/or modify
+**      it under the terms of the GNU General Public License as published by
+**      the Free Software Foundation, either version 3 of the License, or
+**      (at your option) any later version.
+**
+**      This program is distributed in the hope that it will be useful,
+**      but WITHOUT ANY WARRANTY; without even the implied warranty of
+**      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**      GNU General Public License for more details.
+**
+**      You should have received a copy of the GNU General Public License
+**      along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * Tests #cx_try_deadline.
+ */
+
+// local
+#include "config.h"                     /* must go first */
+#include "c_exception.h"
+#include "cx_deadline.h"
+#include "unit_test.h"
+
+// standard
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sysexits.h>
+#include <time.h>
+
+///////////////////////////////////////////////////////////////////////////////
+
+#define TEST_MS           1000000u      /* nanoseconds per millisecond */
+
+// extern variables
+char const   *me;
+
+// local variables
+static unsigned long volatile test_spins;
+static unsigned test_failures;
+
+////////// local functions ////////////////////////////////////////////////////
+
+/**
+ * Gets the current `CLOCK_MONOTONIC` time.
+ *
+ * @return Returns said time in nanoseconds.
+ */
+static uint64_t test_now( void ) {
+  struct timespec now;
+  clock_gettime( CLOCK_MONOTONIC, &now );
+  return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+/**
+ * Spins for \a ns nanoseconds.
+ *
+ * @param ns The number of nanoseconds to spin for.
+ */
+static void test_spin( uint64_t ns ) {
+  uint64_t const end = test_now() + ns;
+  while ( test_now() < end )
+    ++test_spins;
+}
+
+/**
+ * Spins forever.
+ */
+_Noreturn
+static void test_spin_forever( void ) {
+  for (;;)
+    ++test_spins;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static bool test_deadline_caught_within( void ) {
+  TEST_FN_BEGIN();
+  unsigned volatile n_inner_catch = 0;
+  bool volatile timed_out = false;
+  cx_try {
+    cx_try_deadline( 10 * TEST_MS ) {
+      cx_try {
+        test_spin_forever();
+      }
+      cx_catch() {
+        ++n_inner_catch;              // swallows the timeout ...
+      }
+      test_spin_forever();            // ... but it's thrown again
+    }
+  }
+  cx_catch( CX_XID_TIMEOUT ) {
+    timed_out = true;
+  }
+  TEST( n_inner_catch == 1 );
+  TEST( timed_out );
+  TEST_FN_END();
+}
+
+static bool test_deadline_stale( void ) {
+  TEST_FN_BEGIN();
+  cx_try_deadline( 5 * TEST_MS ) {
+    ++test_spins;
+  }
+  // The timer is left armed, but when it goes off, it must neither throw nor
+  // be re-armed, so the sleep is interrupted at most once.
+  struct timespec ts = { .tv_nsec = 20 * TEST_MS };
+  unsigned n_eintr = 0;
+  while ( nanosleep( &ts, &ts ) != 0 && errno == EINTR )
+    ++n_eintr;
+  TEST( n_eintr <= 1 );
+  TEST( cx_current_exception() == NULL );
+  TEST_FN_END();
+}
+
+static bool test_deadline_nested( void ) {
+  TEST_FN_BEGIN();
+  unsigned volatile n_inner_finally = 0;
+  bool volatile timed_out = false;
+  cx_try_deadline( 10 * TEST_MS ) {
+    cx_try_deadline( 10000 * TEST_MS ) {
+      test_spin_forever();
+    }
+    cx_finally {
+      ++n_inner_finally;
+    }
+  }
+  cx_catch( CX_XID_TIMEOUT ) {
+    timed_out = true;
+  }
+  TEST( n_inner_finally == 1 );
+  TEST( timed_out );
+  TEST_FN_END();
+}
+
+static bool test_deadline_no_timeout( void ) {
+  TEST_FN_BEGIN();
+  unsigned volatile n_catch = 0;
+  for ( unsigned volatile i = 0; i < 1000; ++i ) {
+    cx_try_deadline( 5 * TEST_MS ) {
+      ++test_spins;
+    }
+    cx_catch() {
+      ++n_catch;
+    }
+  } // for
+  // Let the timer go off after the blocks have ended: nothing should happen.
+  test_spin( 20 * TEST_MS );
+  TEST( n_catch == 0 );
+  TEST( cx_current_exception() == NULL );
+  TEST_FN_END();
+}
+
+static bool test_deadline_noexcept( void ) {
+  TEST_FN_BEGIN();
+  bool volatile timed_out = false;
+  uint64_t volatile noexcept_end = 0;
+  cx_try_deadline( 5 * TEST_MS ) {
+    cx_noexcept {
+      test_spin( 20 * TEST_MS );        // not interruptible
+    }
+    noexcept_end = test_now();
+    test_spin_forever();
+  }
+  cx_catch( CX_XID_TIMEOUT ) {
+    timed_out = true;
+  }
+  TEST( timed_out );
+  TEST( noexcept_end != 0 );
+  TEST_FN_END();
+}
+
+static bool test_deadline_timeout( void ) {
+  TEST_FN_BEGIN();
+  unsigned volatile n_finally = 0;
+  bool volatile timed_out = false;
+  uint64_t const volatile start = test_now();
+  cx_try_deadline( 10 * TEST_MS ) {
+    test_spin_forever();
+  }
+  cx_catch( CX_XID_TIMEOUT ) {
+    timed_out = true;
+    TEST( cx_current_exception()->thrown_xid == CX_XID_TIMEOUT );
+  }
+  cx_finally {
+    ++n_finally;
+  }
+  TEST( timed_out );
+  TEST( n_finally == 1 );
+  TEST( test_now() - start >= 10 * TEST_MS );
+  TEST_FN_END();
+}
+
+/**
+ * Runs the tests on a thread.
+ *
+ * @param arg Not used.
+ * @return Always returns NULL.
+ */
+static void* test_thread_main( void *arg ) {
+  (void)arg;
+  test_deadline_timeout();
+  test_deadline_no_timeout();
+  return NULL;
+}
+
+static bool test_deadline_thread( void ) {
+  TEST_FN_BEGIN();
+  pthread_t thread;
+  TEST( pthread_create( &thread, NULL, &test_thread_main, NULL ) == 0 );
+  TEST( pthread_join( thread, NULL ) == 0 );
+  TEST_FN_END();
+}
+
+int main( int argc, char const *argv[] ) {
+  (void)argc;
+  me = argv[0];
+
+  test_deadline_timeout();
+  test_deadline_no_timeout();
+  test_deadline_nested();
+  test_deadline_caught_within();
+  test_deadline_noexcept();
+  test_deadline_stale();
+  test_deadline_thread();
+
+  printf( "%u failures\n", test_failures );
+  exit( test_failures > 0 ? EX_SOFTWARE : EX_OK );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/* vim:set et sw=2 ts=2: */
@@ -0,0 +1,209 @@
+/*
+**      C Exception -- Exception Library for C
+**      src/cx_event_loop.c
+**
+**      Copyright (C) 2023-2024  Paul J. Lucas
+**
+**      This program is free software: you can redistribute it and/or modify
+**      it under the terms of the GNU General Public License as published by
+**      the Free Software Foundation, either version 3 of the License, or
+**      (at your option) any later version.
+**
+**      This program is distributed in the hope that it will be useful,
+**      but WITHOUT ANY WARRANTY; without even the implied warranty of
+**      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**      GNU General Public License for more details.
+**
+**      You should have received a copy of the GNU General Public License
+**      along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * Defines types and functions for an `epoll`-based event loop.
+ */
+
+// local
+#include "config.h"                     /* must go first */
+#include "cx_event_loop.h"
+
+// standard
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @addtogroup cx-event-loop-group
+ * @{
+ */
+
+/**
+ * The maximum number of events dispatched per batch.
+ */
+#define CX_IMPL_EVENT_LOOP_BATCH_SIZE 64
+
+/**
+ * An `epoll`-based event loop.
+ */
+struct cx_event_loop {
+  int       epoll_fd;                   ///< The `epoll` file descriptor.
+  bool      stopping;                   ///< Was cx_event_loop_stop() called?
+
+  /**
+   * The number of events in \ref events of the current batch.
+   */
+  unsigned  n_events;
+
+  /**
+   * The index of the event in \ref events being dispatched.
+   *
+   * @remarks It's a member rather than a local variable so it's preserved
+   * when an exception is caught.
+   */
+  unsigned  next;
+
+  /**
+   * The events of the current batch.  The `data.ptr` of each is its \ref
+   * cx_event_source or NULL if it was removed during the batch.
+   */
+  struct epoll_event events[ CX_IMPL_EVENT_LOOP_BATCH_SIZE ];
+};
+
+////////// local functions ////////////////////////////////////////////////////
+
+/**
+ * Dispatches the events of the current batch of \a loop.
+ *
+ * @remarks All events are dispatched within a single #cx_try block.  Only if
+ * a callback throws is a new one entered for the remaining events.
+ *
+ * @param loop The \ref cx_event_loop to dispatch the events of.
+ */
+static void cx_impl_event_loop_dispatch( cx_event_loop_t *loop ) {
+  while ( loop->next < loop->n_events ) {
+    cx_try {
+      for ( ; loop->next < loop->n_events; ++loop->next ) {
+        struct epoll_event const *const ev = &loop->events[ loop->next ];
+        cx_event_source_t *const src = ev->data.ptr;
+        if ( src != NULL )
+          (*src->on_event)( src, ev->events );
+      } // for
+    }
+    cx_catch() {
+      cx_event_source_t *const src = loop->events[ loop->next ].data.ptr;
+      //
+      // Increment next only after on_error returns so that, should it call
+      // cx_event_loop_remove(), the events after src are still considered.
+      //
+      (*src->on_error)( src, cx_current_exception() );
+      ++loop->next;
+    }
+  } // while
+}
+
+/**
+ * Adds or modifies \a src in \a loop.
+ *
+ * @param loop The \ref cx_event_loop.
+ * @param op Either `EPOLL_CTL_ADD` or `EPOLL_CTL_MOD`.
+ * @param src The \ref cx_event_source to add or modify.
+ * @param events The `epoll` events to wait for.
+ * @return Returns `true` only if successful.
+ */
+static bool cx_impl_event_loop_ctl( cx_event_loop_t *loop, int op,
+                                    cx_event_source_t *src, uint32_t events ) {
+  assert( loop != NULL );
+  assert( src != NULL );
+  assert( src->on_event != NULL );
+  assert( src->on_error != NULL );
+  struct epoll_event ev = { .events = events, .data.ptr = src };
+  return epoll_ctl( loop->epoll_fd, op, src->fd, &ev ) == 0;
+}
+
+////////// extern functions ///////////////////////////////////////////////////
+
+bool cx_event_loop_add( cx_event_loop_t *loop, cx_event_source_t *src,
+                        uint32_t events ) {
+  return cx_impl_event_loop_ctl( loop, EPOLL_CTL_ADD, src, events );
+}
+
+void cx_event_loop_free( cx_event_loop_t *loop ) {
+  if ( loop == NULL )
+    return;
+  close( loop->epoll_fd );
+  free( loop );
+}
+
+bool cx_event_loop_modify( cx_event_loop_t *loop, cx_event_source_t *src,
+                           uint32_t events ) {
+  return cx_impl_event_loop_ctl( loop, EPOLL_CTL_MOD, src, events );
+}
+
+cx_event_loop_t* cx_event_loop_new( void ) {
+  cx_event_loop_t *const loop = malloc( sizeof *loop );
+  if ( loop == NULL )
+    return NULL;
+  *loop = (cx_event_loop_t){ .epoll_fd = epoll_create1( EPOLL_CLOEXEC ) };
+  if ( loop->epoll_fd == -1 ) {
+    int const epoll_errno = errno;
+    free( loop );
+    errno = epoll_errno;
+    return NULL;
+  }
+  return loop;
+}
+
+bool cx_event_loop_remove( cx_event_loop_t *loop, cx_event_source_t *src ) {
+  assert( loop != NULL );
+  assert( src != NULL );
+  // Don't dispatch any remaining events for src in the current batch.
+  for ( unsigned i = loop->next + 1; i < loop->n_events; ++i ) {
+    if ( loop->events[i].data.ptr == src )
+      loop->events[i].data.ptr = NULL;
+  } // for
+  return epoll_ctl( loop->epoll_fd, EPOLL_CTL_DEL, src->fd, NULL ) == 0;
+}
+
+bool cx_event_loop_run( cx_event_loop_t *loop ) {
+  assert( loop != NULL );
+  loop->stopping = false;
+  while ( !loop->stopping ) {
+    if ( cx_event_loop_run_once( loop, -1 ) == -1 )
+      return false;
+  } // while
+  return true;
+}
+
+int cx_event_loop_run_once( cx_event_loop_t *loop, int timeout_ms ) {
+  assert( loop != NULL );
+  assert( loop->n_events == 0 );        // not reentrant
+  int const n = epoll_wait(
+    loop->epoll_fd, loop->events, CX_IMPL_EVENT_LOOP_BATCH_SIZE, timeout_ms
+  );
+  if ( n == -1 )
+    return errno == EINTR ? 0 : -1;
+  loop->n_events = (unsigned)n;
+  loop->next = 0;
+  cx_try {
+    cx_impl_event_loop_dispatch( loop );
+  }
+  cx_finally {
+    // In case an on_error function threw.
+    loop->n_events = loop->next = 0;
+  }
+  return n;
+}
+
+void cx_event_loop_stop( cx_event_loop_t *loop ) {
+  assert( loop != NULL );
+  loop->stopping = true;
+}
+
+/** @} */
+
+///////////////////////////////////////////////////////////////////////////////
+/* vim:set et sw=2 ts=2: */
@@ -0,0 +1,224 @@
+/*
+**      C Exception -- Exception Library for C
+**      src/cx_event_loop.h
+**
+**      Copyright (C) 2023-2024  Paul J. Lucas
+**
+**      This program is free software: you can redistribute it and/or modify
+**      it under the terms of the GNU General Public License as published by
+**      the Free Software Foundation, either version 3 of the License, or
+**      (at your option) any later version.
+**
+**      This program is distributed in the hope that it will be useful,
+**      but WITHOUT ANY WARRANTY; without even the implied warranty of
+**      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**      GNU General Public License for more details.
+**
+**      You should have received a copy of the GNU General Public License
+**      along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CX_EVENT_LOOP_H
+#define CX_EVENT_LOOP_H
+
+/**
+ * @file
+ * Declares types and functions for an `epoll`-based event loop that routes
+ * exceptions thrown by event callbacks to the error handler of the event
+ * source that threw them.
+ */
+
+// local
+#include "c_exception.h"
+
+// standard
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @defgroup cx-event-loop-group Event Loop
+ * Types and functions for an `epoll`-based event loop.
+ *
+ * @remarks
+ * @parblock
+ * Ready events are dispatched in batches within a single #cx_try block per
+ * batch rather than one per callback.  If a callback throws an exception that
+ * it doesn't catch, the exception is passed to the error handler of the
+ * callback's \ref cx_event_source, then dispatching continues with the next
+ * event of the batch in a new #cx_try block.  Hence, a failing source costs
+ * the others nothing.
+ *
+ * For example:
+ *  ```c
+ *  struct conn {
+ *    cx_event_source_t src;            // must be first
+ *    // ...
+ *  };
+ *
+ *  static void conn_on_event( cx_event_source_t *src, uint32_t events ) {
+ *    struct conn *const c = (struct conn*)src;
+ *    conn_read( c );                   // may throw
+ *  }
+ *
+ *  static void conn_on_error( cx_event_source_t *src,
+ *                             cx_exception_t const *cex ) {
+ *    struct conn *const c = (struct conn*)src;
+ *    log_error( c, cex );
+ *    cx_event_loop_remove( loop, src );
+ *    conn_free( c );
+ *  }
+ *  ```
+ * @endparblock
+ *
+ * @{
+ */
+
+/**
+ * An `epoll`-based event loop.
+ *
+ * @sa cx_event_loop_new()
+ */
+typedef struct cx_event_loop cx_event_loop_t;
+
+/**
+ * A source of events.
+ *
+ * @sa cx_event_source
+ */
+typedef struct cx_event_source cx_event_source_t;
+
+/**
+ * The signature for a function called when a \ref cx_event_source is ready.
+ *
+ * @param src The \ref cx_event_source that's ready.
+ * @param events The `epoll` events that occurred, e.g., `EPOLLIN`.
+ */
+typedef void (*cx_event_fn_t)( cx_event_source_t *src, uint32_t events );
+
+/**
+ * The signature for a function called when the \ref cx_event_fn_t of a \ref
+ * cx_event_source throws an exception it doesn't catch.
+ *
+ * @param src The \ref cx_event_source whose callback threw.
+ * @param cex The exception.  It's valid only during the call.
+ *
+ * @note If it throws, the exception propagates out of
+ * cx_event_loop_run_once() and the remaining events of the batch are not
+ * dispatched.
+ */
+typedef void (*cx_event_error_fn_t)( cx_event_source_t *src,
+                                     cx_exception_t const *cex );
+
+/**
+ * A source of events, typically a connection, that can be embedded as the
+ * first member of a larger structure.
+ */
+struct cx_event_source {
+  int                 fd;               ///< File descriptor to wait on.
+  cx_event_fn_t       on_event;         ///< Called when \ref fd is ready.
+  cx_event_error_fn_t on_error;         ///< Called if \ref on_event throws.
+};
+
+/**
+ * Adds \a src to \a loop.
+ *
+ * @param loop The \ref cx_event_loop to add to.
+ * @param src The \ref cx_event_source to add.
+ * @param events The `epoll` events to wait for, e.g., `EPOLLIN`.
+ * @return Returns `true` only if successful; otherwise `false` and `errno` is
+ * set.
+ *
+ * @sa cx_event_loop_remove()
+ */
+bool cx_event_loop_add( cx_event_loop_t *loop, cx_event_source_t *src,
+                        uint32_t events );
+
+/**
+ * Frees \a loop.
+ *
+ * @param loop The \ref cx_event_loop to free.  If NULL, does nothing.
+ *
+ * @note Event sources aren't freed.
+ */
+void cx_event_loop_free( cx_event_loop_t *loop );
+
+/**
+ * Modifies the events \a src waits for.
+ *
+ * @param loop The \ref cx_event_loop \a src was added to.
+ * @param src The \ref cx_event_source to modify.
+ * @param events The new `epoll` events to wait for.
+ * @return Returns `true` only if successful; otherwise `false` and `errno` is
+ * set.
+ */
+bool cx_event_loop_modify( cx_event_loop_t *loop, cx_event_source_t *src,
+                           uint32_t events );
+
+/**
+ * Creates a new \ref cx_event_loop.
+ *
+ * @return Returns said loop or NULL if it could not be created and `errno` is
+ * set.
+ *
+ * @sa cx_event_loop_free()
+ */
+cx_event_loop_t* cx_event_loop_new( void );
+
+/**
+ * Removes \a src from \a loop.
+ *
+ * @remarks It may be called from any callback, including for a different
+ * source whose events are in the same batch: \a src will not be called again,
+ * so it may be freed immediately, except by its own \ref
+ * cx_event_source::on_event "on_event" that then throws.
+ *
+ * @param loop The \ref cx_event_loop to remove from.
+ * @param src The \ref cx_event_source to remove.
+ * @return Returns `true` only if successful; otherwise `false` and `errno` is
+ * set.
+ */
+bool cx_event_loop_remove( cx_event_loop_t *loop, cx_event_source_t *src );
+
+/**
+ * Runs \a loop until cx_event_loop_stop() is called.
+ *
+ * @param loop The \ref cx_event_loop to run.
+ * @return Returns `true` only if stopped; `false` only if `epoll_wait()`
+ * failed and `errno` is set.
+ */
+bool cx_event_loop_run( cx_event_loop_t *loop );
+
+/**
+ * Waits for events and dispatches one batch of them.
+ *
+ * @param loop The \ref cx_event_loop to run.
+ * @param timeout_ms The maximum number of milliseconds to wait; -1 waits
+ * indefinitely.
+ * @return Returns the number of events dispatched or -1 if `epoll_wait()`
+ * failed and `errno` is set.
+ */
+int cx_event_loop_run_once( cx_event_loop_t *loop, int timeout_ms );
+
+/**
+ * Stops \a loop: cx_event_loop_run() returns after the current batch.
+ *
+ * @param loop The \ref cx_event_loop to stop.
+ */
+void cx_event_loop_stop( cx_event_loop_t *loop );
+
+/** @} */
+
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef __cplusplus
+} // extern "C"
+#endif /* __cplusplus */
+
+#endif /* CX_EVENT_LOOP_H */
+/* vim:set et sw=2 ts=2: */
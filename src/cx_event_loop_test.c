@@ -0,0 +1,264 @@
+/*
+**      C Exception -- Exception Library for C
+**      src/cx_event_loop_test.c
+**
+**      Copyright (C) 2023-2024  Paul J. Lucas
+**
+**      This program is free software: you can redistribute it and/or modify
+**      it under the terms of the GNU General Public License as published by
+**      the Free Software Foundation, either version 3 of the License, or
+**      (at your option) any later version.
+**
+**      This program is distributed in the hope that it will be useful,
+**      but WITHOUT ANY WARRANTY; without even the implied warranty of
+**      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**      GNU General Public License for more details.
+**
+**      You should have received a copy of the GNU General Public License
+**      along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * Tests event loops.
+ */
+
+// local
+#include "config.h"                     /* must go first */
+#include "c_exception.h"
+#include "cx_event_loop.h"
+#include "unit_test.h"
+
+// standard
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <sysexits.h>
+#include <unistd.h>
+
+///////////////////////////////////////////////////////////////////////////////
+
+#define TEST_N_SOURCES  3
+#define TEST_XID_01     0x0101
+#define TEST_XID_02     0x0102
+
+/**
+ * A test event source that reads from a pipe.
+ */
+struct test_source {
+  cx_event_source_t   src;              ///< Must be first.
+  int                 write_fd;         ///< Write end of the pipe.
+  int                 throw_xid;        ///< If non-zero, XID to throw.
+  struct test_source *remove;           ///< If non-NULL, source to remove.
+  struct test_source *remove_on_error;  ///< If non-NULL, ditto on error.
+  unsigned            n_event;          ///< Number of times on_event called.
+  unsigned            n_error;          ///< Number of times on_error called.
+  int                 error_xid;        ///< XID passed to on_error.
+};
+typedef struct test_source test_source_t;
+
+// extern variables
+char const           *me;
+
+// local variables
+static cx_event_loop_t *test_loop;
+static unsigned       test_failures;
+
+////////// local functions ////////////////////////////////////////////////////
+
+/**
+ * Reads the byte written to the pipe of \a src, then removes another source
+ * and throws, if requested.
+ *
+ * @param src The \ref test_source.
+ * @param events Not used.
+ */
+static void test_on_event( cx_event_source_t *src, uint32_t events ) {
+  (void)events;
+  test_source_t *const ts = (test_source_t*)src;
+  char c;
+  if ( read( src->fd, &c, 1 ) != 1 )
+    cx_throw( TEST_XID_02 );
+  ++ts->n_event;
+  if ( ts->remove != NULL )
+    cx_event_loop_remove( test_loop, &ts->remove->src );
+  if ( ts->throw_xid != 0 )
+    cx_throw( ts->throw_xid );
+}
+
+/**
+ * Records the exception thrown by the on_event function of \a src, then
+ * removes another source, if requested.
+ *
+ * @param src The \ref test_source.
+ * @param cex The exception thrown.
+ */
+static void test_on_error( cx_event_source_t *src, cx_exception_t const *cex ) {
+  test_source_t *const ts = (test_source_t*)src;
+  ++ts->n_error;
+  ts->error_xid = cex->thrown_xid;
+  if ( ts->remove_on_error != NULL )
+    cx_event_loop_remove( test_loop, &ts->remove_on_error->src );
+}
+
+/**
+ * Calls test_on_event(), then stops #test_loop.
+ *
+ * @param src The \ref test_source.
+ * @param events Not used.
+ */
+static void test_stop_on_event( cx_event_source_t *src, uint32_t events ) {
+  test_on_event( src, events );
+  cx_event_loop_stop( test_loop );
+}
+
+/**
+ * Initializes \a ts, adds it to #test_loop, and makes it readable.
+ *
+ * @param ts The \ref test_source to initialize.
+ * @return Returns `true` only if successful.
+ */
+static bool test_source_init( test_source_t *ts ) {
+  int fds[2];
+  if ( pipe( fds ) == -1 )
+    return false;
+  *ts = (test_source_t){
+    .src = { .fd = fds[0], .on_event = &test_on_event,
+             .on_error = &test_on_error },
+    .write_fd = fds[1]
+  };
+  return  cx_event_loop_add( test_loop, &ts->src, EPOLLIN ) &&
+          write( ts->write_fd, "x", 1 ) == 1;
+}
+
+/**
+ * Removes \a ts from #test_loop, if not already removed, and closes its pipe.
+ *
+ * @param ts The \ref test_source to clean up.
+ */
+static void test_source_cleanup( test_source_t *ts ) {
+  cx_event_loop_remove( test_loop, &ts->src );
+  close( ts->src.fd );
+  close( ts->write_fd );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+static bool test_event_loop_error( void ) {
+  TEST_FN_BEGIN();
+  test_source_t ts[ TEST_N_SOURCES ];
+  for ( unsigned i = 0; i < TEST_N_SOURCES; ++i )
+    TEST( test_source_init( &ts[i] ) );
+  ts[1].throw_xid = TEST_XID_01;
+
+  TEST( cx_event_loop_run_once( test_loop, 1000 ) == TEST_N_SOURCES );
+  for ( unsigned i = 0; i < TEST_N_SOURCES; ++i )
+    TEST( ts[i].n_event == 1 );
+  TEST( ts[0].n_error == 0 );
+  TEST( ts[1].n_error == 1 );
+  TEST( ts[1].error_xid == TEST_XID_01 );
+  TEST( ts[2].n_error == 0 );
+  TEST( cx_current_exception() == NULL );
+
+  // Nothing else is ready.
+  TEST( cx_event_loop_run_once( test_loop, 0 ) == 0 );
+
+  for ( unsigned i = 0; i < TEST_N_SOURCES; ++i )
+    test_source_cleanup( &ts[i] );
+  TEST_FN_END();
+}
+
+static bool test_event_loop_errors( void ) {
+  TEST_FN_BEGIN();
+  test_source_t ts[ TEST_N_SOURCES ];
+  for ( unsigned i = 0; i < TEST_N_SOURCES; ++i ) {
+    TEST( test_source_init( &ts[i] ) );
+    ts[i].throw_xid = TEST_XID_01;
+  } // for
+
+  TEST( cx_event_loop_run_once( test_loop, 1000 ) == TEST_N_SOURCES );
+  for ( unsigned i = 0; i < TEST_N_SOURCES; ++i ) {
+    TEST( ts[i].n_event == 1 );
+    TEST( ts[i].n_error == 1 );
+  } // for
+  TEST( cx_current_exception() == NULL );
+
+  for ( unsigned i = 0; i < TEST_N_SOURCES; ++i )
+    test_source_cleanup( &ts[i] );
+  TEST_FN_END();
+}
+
+static bool test_event_loop_remove( void ) {
+  TEST_FN_BEGIN();
+  test_source_t ts[2];
+  for ( unsigned i = 0; i < 2; ++i )
+    TEST( test_source_init( &ts[i] ) );
+  // Whichever is dispatched first removes the other.
+  ts[0].remove = &ts[1];
+  ts[1].remove = &ts[0];
+
+  TEST( cx_event_loop_run_once( test_loop, 1000 ) == 2 );
+  TEST( ts[0].n_event + ts[1].n_event == 1 );
+  TEST( cx_event_loop_run_once( test_loop, 0 ) == 0 );
+
+  for ( unsigned i = 0; i < 2; ++i )
+    test_source_cleanup( &ts[i] );
+  TEST_FN_END();
+}
+
+static bool test_event_loop_remove_on_error( void ) {
+  TEST_FN_BEGIN();
+  test_source_t ts[2];
+  for ( unsigned i = 0; i < 2; ++i ) {
+    TEST( test_source_init( &ts[i] ) );
+    ts[i].throw_xid = TEST_XID_01;
+  } // for
+  // Whichever is dispatched first throws and its on_error removes the other.
+  ts[0].remove_on_error = &ts[1];
+  ts[1].remove_on_error = &ts[0];
+
+  TEST( cx_event_loop_run_once( test_loop, 1000 ) == 2 );
+  TEST( ts[0].n_event + ts[1].n_event == 1 );
+  TEST( ts[0].n_error + ts[1].n_error == 1 );
+  TEST( cx_current_exception() == NULL );
+  TEST( cx_event_loop_run_once( test_loop, 0 ) == 0 );
+
+  for ( unsigned i = 0; i < 2; ++i )
+    test_source_cleanup( &ts[i] );
+  TEST_FN_END();
+}
+
+static bool test_event_loop_run_stop( void ) {
+  TEST_FN_BEGIN();
+  test_source_t ts;
+  TEST( test_source_init( &ts ) );
+  ts.src.on_event = &test_stop_on_event;
+  TEST( cx_event_loop_run( test_loop ) );
+  TEST( ts.n_event == 1 );
+  test_source_cleanup( &ts );
+  TEST_FN_END();
+}
+
+int main( int argc, char const *argv[] ) {
+  (void)argc;
+  me = argv[0];
+
+  test_loop = cx_event_loop_new();
+  if ( test_loop == NULL ) {
+    perror( me );
+    exit( EX_OSERR );
+  }
+
+  test_event_loop_error();
+  test_event_loop_errors();
+  test_event_loop_remove();
+  test_event_loop_remove_on_error();
+  test_event_loop_run_stop();
+
+  cx_event_loop_free( test_loop );
+  printf( "%u failures\n", test_failures );
+  exit( test_failures > 0 ? EX_SOFTWARE : EX_OK );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/* vim:set et sw=2 ts=2: */
@@ -0,0 +1,198 @@
+/*
+**      C Exception -- Exception Library for C
+**      src/cx_omp.h
+**
+**      Copyright (C) 2023-2024  Paul J. Lucas
+**
+**      This program is free software: you can redistribute it and/or modify
+**      it under the terms of the GNU General Public License as published by
+**      the Free Software Foundation, either version 3 of the License, or
+**      (at your option) any later version.
+**
+**      This program is distributed in the hope that it will be useful,
+**      but WITHOUT ANY WARRANTY; without even the implied warranty of
+**      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**      GNU General Public License for more details.
+**
+**      You should have received a copy of the GNU General Public License
+**      along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CX_OMP_H
+#define CX_OMP_H
+
+/**
+ * @file
+ * Declares macros and functions to propagate exceptions thrown within OpenMP
+ * parallel regions to the thread that executes the code after the region.
+ */
+
+// local
+#include "c_exception.h"
+
+// standard
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @defgroup cx-omp-group OpenMP Exception Propagation
+ * Macros and functions to propagate exceptions thrown within OpenMP parallel
+ * regions.
+ *
+ * @remarks
+ * @parblock
+ * The chain of #cx_try blocks is per thread, so an exception thrown within an
+ * OpenMP parallel region on a thread other than the one that began the region
+ * that isn't caught on that thread calls cx_terminate().  It also isn't
+ * possible to `longjmp()` out of a parallel region.
+ *
+ * Instead, the body of the region can be wrapped by #CX_OMP_TRY that catches
+ * any exception and records only the first one thrown by any thread.  Once
+ * one has been thrown, the remaining #CX_OMP_TRY blocks are skipped.  After
+ * the region, #CX_OMP_RETHROW rethrows it, if any.  For example:
+ *  ```c
+ *  cx_omp_exception_t omp_ex = CX_OMP_EXCEPTION_INIT;
+ *  #pragma omp parallel for
+ *  for ( size_t i = 0; i < n_files; ++i ) {
+ *    CX_OMP_TRY( omp_ex ) {
+ *      parse_file( files[i] );         // may throw
+ *    }
+ *  }
+ *  CX_OMP_RETHROW( omp_ex );
+ *  ```
+ * If the region specifies `default(none)`, the \ref cx_omp_exception_t must
+ * be listed as `shared`.
+ * @endparblock
+ *
+ * @note OpenMP itself isn't required to use these: without it, the pragma is
+ * ignored and the loop simply runs serially.
+ *
+ * @{
+ */
+
+/**
+ * The first exception thrown within a #CX_OMP_TRY block of an OpenMP parallel
+ * region.
+ *
+ * @sa #CX_OMP_EXCEPTION_INIT
+ */
+struct cx_omp_exception {
+  /**
+   * The first exception thrown, if any.
+   *
+   * @remarks Once non-NULL, it's never changed until rethrown by
+   * #CX_OMP_RETHROW.
+   */
+  cx_exception_ptr_t *_Atomic xp;
+};
+typedef struct cx_omp_exception cx_omp_exception_t;
+
+/**
+ * Initializer for a \ref cx_omp_exception_t.
+ */
+#define CX_OMP_EXCEPTION_INIT     { .xp = NULL }
+
+/**
+ * Rethrows the first exception, if any, thrown within a #CX_OMP_TRY block.
+ *
+ * @param OMP_EX The \ref cx_omp_exception_t passed to #CX_OMP_TRY.
+ *
+ * @note This must be used after the OpenMP parallel region.
+ *
+ * @sa #CX_OMP_TRY
+ */
+#define CX_OMP_RETHROW(OMP_EX)    cx_omp_rethrow( &(OMP_EX) )
+
+/**
+ * Begins a block that catches any exception thrown within it and records it in
+ * \a OMP_EX if it's the first.  If an exception has already been recorded, the
+ * block is skipped.
+ *
+ * @remarks Unlike #cx_try, it must _not_ be followed by either #cx_catch or
+ * #cx_finally blocks.
+ *
+ * @param OMP_EX The \ref cx_omp_exception_t to record the exception in.
+ *
+ * @sa #CX_OMP_RETHROW
+ */
+#define CX_OMP_TRY(OMP_EX)                                            \
+  if ( !cx_omp_cancelled( &(OMP_EX) ) )                               \
+  CX_IMPL_TRY_FOR( ((int const[]){ 1, false, CX_XID_ANY }) )          \
+    if ( cx_tb.state != CX_IMPL_FINALLY )                             \
+      if ( CX_IMPL_SETJMP( cx_tb.env ) != 0 )                         \
+        cx_impl_omp_catch( &(OMP_EX), &cx_tb );                       \
+      else
+
+/**
+ * Checks whether an exception has been thrown within a #CX_OMP_TRY block.
+ *
+ * @remarks Long-running #CX_OMP_TRY blocks may call this periodically to stop
+ * early.
+ *
+ * @param omp_ex The \ref cx_omp_exception_t to check.
+ * @return Returns `true` only if an exception has been thrown.
+ */
+static inline bool cx_omp_cancelled( cx_omp_exception_t *omp_ex ) {
+  return atomic_load_explicit( &omp_ex->xp, memory_order_relaxed ) != NULL;
+}
+
+/**
+ * Rethrows the first exception, if any, thrown within a #CX_OMP_TRY block.
+ *
+ * @remarks This is called by #CX_OMP_RETHROW.
+ *
+ * @param omp_ex The \ref cx_omp_exception_t to rethrow the exception of.  It is
+ * reset so it can be reused.
+ */
+static inline void cx_omp_rethrow( cx_omp_exception_t *omp_ex ) {
+  cx_exception_ptr_t *const xp =
+    atomic_exchange_explicit( &omp_ex->xp, NULL, memory_order_acquire );
+  if ( xp != NULL )
+    cx_rethrow_ptr( xp );
+}
+
+/** @} */
+
+////////// implementation /////////////////////////////////////////////////////
+
+/// @cond DOXYGEN_IGNORE
+
+/**
+ * Catches the current exception and records it in \a omp_ex if it's the
+ * first.
+ *
+ * @param omp_ex The \ref cx_omp_exception_t to record the exception in.
+ * @param tb A pointer to the current try block.
+ *
+ * @warning This function is called by the implementation only.
+ */
+static inline void cx_impl_omp_catch( cx_omp_exception_t *omp_ex,
+                                      cx_impl_try_block_t *tb ) {
+  if ( !CX_IMPL_CATCH_FN( CX_XID_ANY, tb ) )
+    return;
+  cx_exception_ptr_t *expected = NULL;
+  cx_exception_ptr_t *const xp = cx_exception_ptr_capture();
+  if ( !atomic_compare_exchange_strong_explicit(
+          &omp_ex->xp, &expected, xp,
+          memory_order_release, memory_order_relaxed ) ) {
+    cx_exception_ptr_release( xp );     // not the first
+  }
+}
+
+/// @endcond
+
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef __cplusplus
+} // extern "C"
+#endif /* __cplusplus */
+
+#endif /* CX_OMP_H */
+/* vim:set et sw=2 ts=2: */
@@ -0,0 +1,194 @@
+/*
+**      C Exception -- Exception Library for C
+**      src/cx_omp_bench.c
+**
+**      Copyright (C) 2023-2024  Paul J. Lucas
+**
+**      This program is free software: you can redistribute it and/or modify
+**      it under the terms of the GNU General Public License as published by
+**      the Free Software Foundation, either version 3 of the License, or
+**      (at your option) any later version.
+**
+**      This program is distributed in the hope that it will be useful,
+**      but WITHOUT ANY WARRANTY; without even the implied warranty of
+**      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**      GNU General Public License for more details.
+**
+**      You should have received a copy of the GNU General Public License
+**      along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * Benchmarks #CX_OMP_TRY against the same OpenMP loop written with error
+ * codes.  Run via `make bench`.
+ */
+
+// local
+#include "config.h"                     /* must go first */
+#include "c_exception.h"
+#include "cx_omp.h"
+
+// standard
+#include <attribute.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sysexits.h>
+#include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif /* _OPENMP */
+
+///////////////////////////////////////////////////////////////////////////////
+
+#define BENCH_N           10000000L
+#define BENCH_TASK_WORK   100L          /* loop iterations per element */
+#define BENCH_XID         0x0101
+
+/**
+ * The signature for a benchmark function.
+ *
+ * @param fail_at The index of the element that fails or #BENCH_N for none.
+ * @return Returns `true` only if an element failed.
+ */
+typedef bool (*bench_fn_t)( long fail_at );
+
+// local variables
+static bool bench_processed[ BENCH_N ];
+
+////////// local functions ////////////////////////////////////////////////////
+
+/**
+ * Does a fixed amount of work for element \a i.
+ *
+ * @param i The index of the element.
+ * @return Returns said work.
+ */
+static inline unsigned long bench_work( long i ) {
+  bench_processed[i] = true;
+  unsigned long sum = (unsigned long)i;
+  for ( long j = 0; j < BENCH_TASK_WORK; ++j ) {
+    sum += (unsigned long)j;
+    __asm__ ( "" : "+r" (sum) );        // prevent loop closed-form
+  } // for
+  return sum;
+}
+
+/**
+ * Processes element \a i returning an error code.
+ *
+ * @param i The index of the element.
+ * @param fail_at The index of the element that fails.
+ * @return Returns 0 on success or non-zero on failure.
+ */
+ATTRIBUTE_NOINLINE
+static int bench_process_rv( long i, long fail_at ) {
+  unsigned long volatile sink = bench_work( i );
+  (void)sink;
+  return i == fail_at;
+}
+
+/**
+ * Processes element \a i throwing #BENCH_XID on failure.
+ *
+ * @param i The index of the element.
+ * @param fail_at The index of the element that fails.
+ */
+ATTRIBUTE_NOINLINE
+static void bench_process_throw( long i, long fail_at ) {
+  unsigned long volatile sink = bench_work( i );
+  (void)sink;
+  if ( i == fail_at )
+    cx_throw( BENCH_XID );
+}
+
+/**
+ * Processes all elements using error codes.
+ *
+ * @param fail_at The index of the element that fails or #BENCH_N for none.
+ * @return Returns `true` only if an element failed.
+ */
+ATTRIBUTE_NOINLINE
+static bool bench_error_codes( long fail_at ) {
+  atomic_bool failed = false;
+#pragma omp parallel for
+  for ( long i = 0; i < BENCH_N; ++i ) {
+    if ( atomic_load_explicit( &failed, memory_order_relaxed ) )
+      continue;
+    if ( bench_process_rv( i, fail_at ) != 0 )
+      atomic_store_explicit( &failed, true, memory_order_relaxed );
+  } // for
+  return atomic_load( &failed );
+}
+
+/**
+ * Processes all elements using #CX_OMP_TRY.
+ *
+ * @param fail_at The index of the element that fails or #BENCH_N for none.
+ * @return Returns `true` only if an element failed.
+ */
+ATTRIBUTE_NOINLINE
+static bool bench_omp_try( long fail_at ) {
+  cx_omp_exception_t omp_ex = CX_OMP_EXCEPTION_INIT;
+#pragma omp parallel for
+  for ( long i = 0; i < BENCH_N; ++i ) {
+    CX_OMP_TRY( omp_ex ) {
+      bench_process_throw( i, fail_at );
+    }
+  } // for
+  bool volatile failed = false;
+  cx_try {
+    CX_OMP_RETHROW( omp_ex );
+  }
+  cx_catch( BENCH_XID ) {
+    failed = true;
+  }
+  return failed;
+}
+
+/**
+ * Runs \a fn and prints the elapsed time.
+ *
+ * @param name The name of the benchmark.
+ * @param fn The benchmark function to run.
+ * @param fail_at The index of the element that fails or #BENCH_N for none.
+ */
+static void bench_run( char const *name, bench_fn_t fn, long fail_at ) {
+  struct timespec start, end;
+  for ( long i = 0; i < BENCH_N; ++i )
+    bench_processed[i] = false;
+  clock_gettime( CLOCK_MONOTONIC, &start );
+  bool const failed = (*fn)( fail_at );
+  clock_gettime( CLOCK_MONOTONIC, &end );
+  long n_processed = 0;
+  for ( long i = 0; i < BENCH_N; ++i )
+    n_processed += bench_processed[i];
+  double const ms = (double)(end.tv_sec - start.tv_sec) * 1e3
+                  + (double)(end.tv_nsec - start.tv_nsec) / 1e6;
+  printf( "  %-28s %10.2f ms %10ld processed%s\n",
+          name, ms, n_processed, failed ? " (failed)" : "" );
+}
+
+int main( void ) {
+#ifdef _OPENMP
+  int const n_threads = omp_get_max_threads();
+#else
+  int const n_threads = 1;
+#endif /* _OPENMP */
+
+  printf( "OpenMP success path (%ld elements, %d thread(s)):\n",
+          BENCH_N, n_threads );
+  bench_run( "error codes", &bench_error_codes, BENCH_N );
+  bench_run( "CX_OMP_TRY", &bench_omp_try, BENCH_N );
+
+  printf( "OpenMP failure path (element %ld fails):\n", BENCH_N / 10 );
+  bench_run( "error codes", &bench_error_codes, BENCH_N / 10 );
+  bench_run( "CX_OMP_TRY", &bench_omp_try, BENCH_N / 10 );
+
+  exit( EX_OK );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/* vim:set et sw=2 ts=2: */
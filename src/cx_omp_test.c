@@ -0,0 +1,132 @@
+/*
+**      C Exception -- Exception Library for C
+**      src/cx_omp_test.c
+**
+**      Copyright (C) 2023-2024  Paul J. Lucas
+**
+**      This program is free software: you can redistribute it and/or modify
+**      it under the terms of the GNU General Public License as published by
+**      the Free Software Foundation, either version 3 of the License, or
+**      (at your option) any later version.
+**
+**      This program is distributed in the hope that it will be useful,
+**      but WITHOUT ANY WARRANTY; without even the implied warranty of
+**      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**      GNU General Public License for more details.
+**
+**      You should have received a copy of the GNU General Public License
+**      along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * Tests #CX_OMP_TRY and #CX_OMP_RETHROW.
+ */
+
+// local
+#include "config.h"                     /* must go first */
+#include "c_exception.h"
+#include "cx_omp.h"
+#include "unit_test.h"
+
+// standard
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sysexits.h>
+
+///////////////////////////////////////////////////////////////////////////////
+
+#define TEST_N            10000
+#define TEST_N_THREADS    4
+#define TEST_XID_01       0x0101
+#define TEST_XID_02       0x0102
+
+// extern variables
+char const   *me;
+
+// local variables
+static unsigned test_failures;
+
+////////// local functions ////////////////////////////////////////////////////
+
+static bool test_omp_no_throw( void ) {
+  TEST_FN_BEGIN();
+  atomic_long sum = 0;
+  cx_omp_exception_t omp_ex = CX_OMP_EXCEPTION_INIT;
+#pragma omp parallel for num_threads(TEST_N_THREADS)
+  for ( long volatile i = 0; i < TEST_N; ++i ) {
+    CX_OMP_TRY( omp_ex ) {
+      atomic_fetch_add( &sum, i );
+    }
+  } // for
+  unsigned volatile n_catch = 0;
+  cx_try {
+    CX_OMP_RETHROW( omp_ex );
+  }
+  cx_catch() {
+    ++n_catch;
+  }
+  TEST( n_catch == 0 );
+  TEST( atomic_load( &sum ) == (long)TEST_N * (TEST_N - 1) / 2 );
+  TEST_FN_END();
+}
+
+static bool test_omp_nested_catch( void ) {
+  TEST_FN_BEGIN();
+  atomic_uint n_inner_catch = 0;
+  cx_omp_exception_t omp_ex = CX_OMP_EXCEPTION_INIT;
+#pragma omp parallel for num_threads(TEST_N_THREADS)
+  for ( int volatile i = 0; i < TEST_N; ++i ) {
+    CX_OMP_TRY( omp_ex ) {
+      cx_try {
+        cx_throw( TEST_XID_01 );
+      }
+      cx_catch( TEST_XID_01 ) {
+        atomic_fetch_add( &n_inner_catch, 1 );
+      }
+    }
+  } // for
+  TEST( !cx_omp_cancelled( &omp_ex ) );
+  TEST( atomic_load( &n_inner_catch ) == TEST_N );
+  TEST_FN_END();
+}
+
+static bool test_omp_throw( void ) {
+  TEST_FN_BEGIN();
+  cx_omp_exception_t omp_ex = CX_OMP_EXCEPTION_INIT;
+#pragma omp parallel for num_threads(TEST_N_THREADS)
+  for ( int volatile i = 0; i < TEST_N; ++i ) {
+    CX_OMP_TRY( omp_ex ) {
+      if ( i % 100 == 0 )
+        cx_throw( TEST_XID_02 );
+    }
+  } // for
+  TEST( cx_omp_cancelled( &omp_ex ) );
+  unsigned volatile n_catch = 0;
+  cx_try {
+    CX_OMP_RETHROW( omp_ex );
+  }
+  cx_catch( TEST_XID_02 ) {
+    ++n_catch;
+  }
+  TEST( n_catch == 1 );
+  TEST( !cx_omp_cancelled( &omp_ex ) );
+  TEST( cx_current_exception() == NULL );
+  TEST_FN_END();
+}
+
+int main( int argc, char const *argv[] ) {
+  (void)argc;
+  me = argv[0];
+
+  test_omp_no_throw();
+  test_omp_nested_catch();
+  test_omp_throw();
+
+  printf( "%u failures\n", test_failures );
+  exit( test_failures > 0 ? EX_SOFTWARE : EX_OK );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/* vim:set et sw=2 ts=2: */
@@ -0,0 +1,624 @@
+/*
+**      C Exception -- Exception Library for C
+**      src/cx_task_group.c
+**
+**      Copyright (C) 2023-2024  Paul J. Lucas
+**
+**      This program is free software: you can redistribute it and/or modify
+**      it under the terms of the GNU General Public License as published by
+**      the Free Software Foundation, either version 3 of the License, or
+**      (at your option) any later version.
+**
+**      This program is distributed in the hope that it will be useful,
+**      but WITHOUT ANY WARRANTY; without even the implied warranty of
+**      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**      GNU General Public License for more details.
+**
+**      You should have received a copy of the GNU General Public License
+**      along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * Defines types and functions to run groups of tasks on a pool of worker
+ * threads.
+ */
+
+// local
+#include "config.h"                     /* must go first */
+#include "cx_task_group.h"
+
+// standard
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @addtogroup cx-task-group-group
+ * @{
+ */
+
+/**
+ * The capacity of a worker's task deque.  It must be a power of 2.  When a
+ * deque is full, tasks are queued on the pool's shared queue instead.
+ */
+#define CX_IMPL_DEQUE_CAPACITY    1024u
+
+/**
+ * The size of a cache line used to prevent false sharing between workers.
+ */
+#define CX_IMPL_CACHE_LINE_SIZE   64
+
+typedef struct cx_impl_task   cx_impl_task_t;
+typedef struct cx_impl_worker cx_impl_worker_t;
+
+/**
+ * A task to run.
+ */
+struct cx_impl_task {
+  cx_task_fn_t      fn;                 ///< Task function.
+  void             *arg;                ///< Argument to \ref fn.
+  cx_task_group_t  *group;              ///< Group it belongs to.
+  cx_impl_task_t   *next;               ///< Next task in shared queue, if any.
+};
+
+/**
+ * A Chase-Lev work-stealing deque of tasks: the owning worker pushes and
+ * takes at the bottom; other threads steal from the top.
+ *
+ * @sa [Correct and Efficient Work-Stealing for Weak Memory
+ * Models](https://doi.org/10.1145/2442516.2442524)
+ */
+struct cx_impl_deque {
+  _Alignas(CX_IMPL_CACHE_LINE_SIZE)
+  atomic_long                 top;      ///< Index of next task to steal.
+  _Alignas(CX_IMPL_CACHE_LINE_SIZE)
+  atomic_long                 bottom;   ///< Index of next task to push.
+  _Atomic(cx_impl_task_t*)    tasks[ CX_IMPL_DEQUE_CAPACITY ];
+};
+typedef struct cx_impl_deque cx_impl_deque_t;
+
+/**
+ * A worker thread.
+ */
+struct cx_impl_worker {
+  cx_impl_deque_t   deque;              ///< Its tasks.
+  cx_task_pool_t   *pool;               ///< Pool it belongs to.
+  pthread_t         thread;             ///< Its thread.
+  unsigned          rand_state;         ///< For choosing victims to steal from.
+};
+
+/**
+ * A pool of worker threads.
+ */
+struct cx_task_pool {
+  cx_impl_worker_t *workers;            ///< Its workers.
+  unsigned          n_workers;          ///< Number of workers.
+
+  /**
+   * The number of tasks queued, but not yet started.
+   */
+  atomic_long       n_queued;
+
+  /**
+   * The number of workers waiting for tasks to be queued.
+   */
+  atomic_int        n_sleeping;
+
+  pthread_mutex_t   mutex;              ///< Guards the fields below.
+  pthread_cond_t    work_available;     ///< Signalled when a task is queued.
+
+  /**
+   * Shared queue head, if any.  It's modified only while \ref mutex is
+   * locked, but is atomic so cx_impl_task_pool_find() can check it without.
+   */
+  _Atomic(cx_impl_task_t*) shared_head;
+
+  cx_impl_task_t   *shared_tail;        ///< Shared queue tail, if any.
+  bool              stopping;           ///< Is the pool being freed?
+};
+
+/**
+ * A group of tasks.
+ */
+struct cx_task_group {
+  cx_task_pool_t       *pool;           ///< Pool to run tasks on.
+
+  /**
+   * The number of tasks not yet finished plus 1 until cx_task_group_wait() is
+   * called.
+   */
+  atomic_long           pending;
+
+  atomic_bool           cancelled;      ///< Did a task throw an exception?
+
+  pthread_mutex_t       mutex;          ///< Guards the fields below.
+  pthread_cond_t        finished;       ///< Signalled when \ref done is set.
+  bool                  done;           ///< Are all tasks finished?
+  cx_exception_ptr_t  **xps;            ///< Exceptions thrown by tasks.
+  size_t                n_xps;          ///< Number of exceptions.
+  size_t                xps_cap;        ///< Capacity of \ref xps.
+};
+
+/**
+ * The worker of the current thread, if any.
+ */
+static _Thread_local cx_impl_worker_t *cx_impl_current_worker;
+
+////////// local functions ////////////////////////////////////////////////////
+
+/**
+ * Checks \a rv, the return value of a `pthread_*()` function, and aborts if
+ * it's non-zero.
+ *
+ * @param rv The return value.
+ * @param what The name of the function.
+ */
+static void cx_impl_pthread_check( int rv, char const *what ) {
+  if ( rv == 0 )
+    return;
+  fprintf( stderr, "%s() failed: %d\n", what, rv );
+  abort();
+}
+
+/**
+ * Pushes \a task onto the bottom of \a deque.
+ *
+ * @remarks Only the owning worker may call this.
+ *
+ * @param deque The \ref cx_impl_deque to push onto.
+ * @param task The task to push.
+ * @return Returns `true` only if \a task was pushed; `false` if \a deque is
+ * full.
+ */
+static bool cx_impl_deque_push( cx_impl_deque_t *deque, cx_impl_task_t *task ) {
+  long const b = atomic_load_explicit( &deque->bottom, memory_order_relaxed );
+  long const t = atomic_load_explicit( &deque->top, memory_order_acquire );
+  if ( b - t >= (long)CX_IMPL_DEQUE_CAPACITY )
+    return false;
+  atomic_store_explicit(
+    &deque->tasks[ (unsigned long)b & (CX_IMPL_DEQUE_CAPACITY - 1) ], task,
+    memory_order_relaxed
+  );
+  atomic_thread_fence( memory_order_release );
+  atomic_store_explicit( &deque->bottom, b + 1, memory_order_relaxed );
+  return true;
+}
+
+/**
+ * Steals a task from the top of \a deque.
+ *
+ * @param deque The \ref cx_impl_deque to steal from.
+ * @return Returns said task or NULL if either \a deque is empty or another
+ * thread took the task first.
+ */
+static cx_impl_task_t* cx_impl_deque_steal( cx_impl_deque_t *deque ) {
+  long t = atomic_load_explicit( &deque->top, memory_order_acquire );
+  atomic_thread_fence( memory_order_seq_cst );
+  long const b = atomic_load_explicit( &deque->bottom, memory_order_acquire );
+  if ( t >= b )
+    return NULL;
+  cx_impl_task_t *const task = atomic_load_explicit(
+    &deque->tasks[ (unsigned long)t & (CX_IMPL_DEQUE_CAPACITY - 1) ],
+    memory_order_relaxed
+  );
+  if ( !atomic_compare_exchange_strong_explicit(
+          &deque->top, &t, t + 1,
+          memory_order_seq_cst, memory_order_relaxed ) ) {
+    return NULL;
+  }
+  return task;
+}
+
+/**
+ * Takes a task from the bottom of \a deque.
+ *
+ * @remarks Only the owning worker may call this.
+ *
+ * @param deque The \ref cx_impl_deque to take from.
+ * @return Returns said task or NULL if \a deque is empty.
+ */
+static cx_impl_task_t* cx_impl_deque_take( cx_impl_deque_t *deque ) {
+  long const b =
+    atomic_load_explicit( &deque->bottom, memory_order_relaxed ) - 1;
+  atomic_store_explicit( &deque->bottom, b, memory_order_relaxed );
+  atomic_thread_fence( memory_order_seq_cst );
+  long t = atomic_load_explicit( &deque->top, memory_order_relaxed );
+  if ( t > b ) {                        // empty
+    atomic_store_explicit( &deque->bottom, b + 1, memory_order_relaxed );
+    return NULL;
+  }
+  cx_impl_task_t *task = atomic_load_explicit(
+    &deque->tasks[ (unsigned long)b & (CX_IMPL_DEQUE_CAPACITY - 1) ],
+    memory_order_relaxed
+  );
+  if ( t == b ) {
+    // Last task: race against thieves for it.
+    if ( !atomic_compare_exchange_strong_explicit(
+            &deque->top, &t, t + 1,
+            memory_order_seq_cst, memory_order_relaxed ) ) {
+      task = NULL;
+    }
+    atomic_store_explicit( &deque->bottom, b + 1, memory_order_relaxed );
+  }
+  return task;
+}
+
+/**
+ * Adds \a xp to the exceptions of \a group and cancels it.
+ *
+ * @param group The \ref cx_task_group to add to.
+ * @param xp The exception to add.
+ */
+static void cx_impl_task_group_add_exception( cx_task_group_t *group,
+                                              cx_exception_ptr_t *xp ) {
+  assert( group != NULL );
+  assert( xp != NULL );
+  atomic_store_explicit( &group->cancelled, true, memory_order_relaxed );
+  cx_impl_pthread_check(
+    pthread_mutex_lock( &group->mutex ), "pthread_mutex_lock"
+  );
+  if ( group->n_xps == group->xps_cap ) {
+    group->xps_cap = group->xps_cap == 0 ? 4 : group->xps_cap * 2;
+    group->xps = realloc( group->xps, group->xps_cap * sizeof *group->xps );
+    if ( group->xps == NULL ) {
+      perror( "realloc()" );
+      abort();
+    }
+  }
+  group->xps[ group->n_xps++ ] = xp;
+  pthread_mutex_unlock( &group->mutex );
+}
+
+/**
+ * Decrements the number of pending tasks of \a group: if it was the last,
+ * wakes up the thread waiting for it.
+ *
+ * @param group The \ref cx_task_group to decrement.
+ */
+static void cx_impl_task_group_dec_pending( cx_task_group_t *group ) {
+  if ( atomic_fetch_sub_explicit( &group->pending, 1,
+                                  memory_order_acq_rel ) != 1 ) {
+    return;
+  }
+  cx_impl_pthread_check(
+    pthread_mutex_lock( &group->mutex ), "pthread_mutex_lock"
+  );
+  group->done = true;
+  pthread_cond_broadcast( &group->finished );
+  pthread_mutex_unlock( &group->mutex );
+  // The group may be freed at this point.
+}
+
+/**
+ * Runs \a task within its own #cx_try block, then frees it.
+ *
+ * @param task The task to run.
+ */
+static void cx_impl_task_run( cx_impl_task_t *task ) {
+  cx_task_group_t *const group = task->group;
+  if ( !atomic_load_explicit( &group->cancelled, memory_order_relaxed ) ) {
+    cx_try_catching( false, CX_XID_ANY ) {
+      (*task->fn)( task->arg );
+    }
+    cx_catch() {
+      cx_impl_task_group_add_exception( group, cx_exception_ptr_capture() );
+    }
+  }
+  free( task );
+  cx_impl_task_group_dec_pending( group );
+}
+
+/**
+ * Takes a task from the shared queue of \a pool, if any.
+ *
+ * @param pool The \ref cx_task_pool to take from.
+ * @return Returns said task or NULL if none.
+ */
+static cx_impl_task_t* cx_impl_task_pool_take_shared( cx_task_pool_t *pool ) {
+  cx_impl_pthread_check(
+    pthread_mutex_lock( &pool->mutex ), "pthread_mutex_lock"
+  );
+  cx_impl_task_t *const task =
+    atomic_load_explicit( &pool->shared_head, memory_order_relaxed );
+  if ( task != NULL ) {
+    atomic_store_explicit( &pool->shared_head, task->next,
+                           memory_order_relaxed );
+    if ( task->next == NULL )
+      pool->shared_tail = NULL;
+  }
+  pthread_mutex_unlock( &pool->mutex );
+  return task;
+}
+
+/**
+ * Finds a task to run: first from \a self's own deque, if any; then from the
+ * shared queue of \a pool; then by stealing from other workers.
+ *
+ * @param pool The \ref cx_task_pool to find a task in.
+ * @param self The current worker or NULL if the current thread isn't one.
+ * @return Returns said task or NULL if none.
+ */
+static cx_impl_task_t* cx_impl_task_pool_find( cx_task_pool_t *pool,
+                                               cx_impl_worker_t *self ) {
+  if ( atomic_load_explicit( &pool->n_queued, memory_order_relaxed ) <= 0 )
+    return NULL;
+
+  cx_impl_task_t *task = NULL;
+  if ( self != NULL )
+    task = cx_impl_deque_take( &self->deque );
+  if ( task == NULL && atomic_load_explicit( &pool->shared_head,
+                                             memory_order_relaxed ) != NULL ) {
+    task = cx_impl_task_pool_take_shared( pool );
+  }
+
+  if ( task == NULL ) {
+    unsigned start = 0;
+    if ( self != NULL ) {
+      // xorshift
+      self->rand_state ^= self->rand_state << 13;
+      self->rand_state ^= self->rand_state >> 17;
+      self->rand_state ^= self->rand_state << 5;
+      start = self->rand_state;
+    }
+    for ( unsigned i = 0; i < pool->n_workers && task == NULL; ++i ) {
+      cx_impl_worker_t *const victim =
+        &pool->workers[ (start + i) % pool->n_workers ];
+      if ( victim != self )
+        task = cx_impl_deque_steal( &victim->deque );
+    } // for
+  }
+
+  if ( task != NULL )
+    atomic_fetch_sub_explicit( &pool->n_queued, 1, memory_order_relaxed );
+  return task;
+}
+
+/**
+ * Queues \a task on \a pool and wakes up a sleeping worker, if any.
+ *
+ * @param pool The \ref cx_task_pool to queue on.
+ * @param task The task to queue.
+ */
+static void cx_impl_task_pool_queue( cx_task_pool_t *pool,
+                                     cx_impl_task_t *task ) {
+  cx_impl_worker_t *const self = cx_impl_current_worker;
+  if ( self == NULL || self->pool != pool ||
+       !cx_impl_deque_push( &self->deque, task ) ) {
+    task->next = NULL;
+    cx_impl_pthread_check(
+      pthread_mutex_lock( &pool->mutex ), "pthread_mutex_lock"
+    );
+    if ( pool->shared_tail == NULL )
+      atomic_store_explicit( &pool->shared_head, task, memory_order_relaxed );
+    else
+      pool->shared_tail->next = task;
+    pool->shared_tail = task;
+    pthread_mutex_unlock( &pool->mutex );
+  }
+  //
+  // Sequentially consistent operations on both n_queued here and n_sleeping
+  // in cx_impl_worker_main() ensure that either we see a sleeping worker or
+  // it sees the queued task.
+  //
+  atomic_fetch_add( &pool->n_queued, 1 );
+  if ( atomic_load( &pool->n_sleeping ) > 0 ) {
+    cx_impl_pthread_check(
+      pthread_mutex_lock( &pool->mutex ), "pthread_mutex_lock"
+    );
+    pthread_cond_signal( &pool->work_available );
+    pthread_mutex_unlock( &pool->mutex );
+  }
+}
+
+/**
+ * The main function of a worker thread.
+ *
+ * @param arg A pointer to the \ref cx_impl_worker.
+ * @return Always returns NULL.
+ */
+static void* cx_impl_worker_main( void *arg ) {
+  cx_impl_worker_t *const self = arg;
+  cx_task_pool_t *const pool = self->pool;
+  cx_impl_current_worker = self;
+
+  for (;;) {
+    cx_impl_task_t *const task = cx_impl_task_pool_find( pool, self );
+    if ( task != NULL ) {
+      cx_impl_task_run( task );
+      continue;
+    }
+    cx_impl_pthread_check(
+      pthread_mutex_lock( &pool->mutex ), "pthread_mutex_lock"
+    );
+    atomic_fetch_add( &pool->n_sleeping, 1 );
+    while ( !pool->stopping && atomic_load( &pool->n_queued ) <= 0 )
+      pthread_cond_wait( &pool->work_available, &pool->mutex );
+    atomic_fetch_sub( &pool->n_sleeping, 1 );
+    bool const stop = pool->stopping && atomic_load( &pool->n_queued ) <= 0;
+    pthread_mutex_unlock( &pool->mutex );
+    if ( stop )
+      break;
+  } // for
+
+  return NULL;
+}
+
+////////// extern functions ///////////////////////////////////////////////////
+
+bool cx_task_group_cancelled( cx_task_group_t const *group ) {
+  assert( group != NULL );
+  return atomic_load_explicit( &group->cancelled, memory_order_relaxed );
+}
+
+cx_exception_ptr_t* cx_task_group_exception( cx_task_group_t const *group,
+                                             size_t i ) {
+  assert( group != NULL );
+  assert( i < group->n_xps );
+  return group->xps[i];
+}
+
+size_t cx_task_group_exception_count( cx_task_group_t const *group ) {
+  assert( group != NULL );
+  return group->n_xps;
+}
+
+void cx_task_group_free( cx_task_group_t *group ) {
+  if ( group == NULL )
+    return;
+  for ( size_t i = 0; i < group->n_xps; ++i )
+    cx_exception_ptr_release( group->xps[i] );
+  free( group->xps );
+  pthread_cond_destroy( &group->finished );
+  pthread_mutex_destroy( &group->mutex );
+  free( group );
+}
+
+cx_task_group_t* cx_task_group_new( cx_task_pool_t *pool ) {
+  assert( pool != NULL );
+  cx_task_group_t *const group = malloc( sizeof *group );
+  if ( group == NULL ) {
+    perror( "malloc()" );
+    abort();
+  }
+  group->pool = pool;
+  atomic_init( &group->pending, 1 );
+  atomic_init( &group->cancelled, false );
+  cx_impl_pthread_check(
+    pthread_mutex_init( &group->mutex, NULL ), "pthread_mutex_init"
+  );
+  cx_impl_pthread_check(
+    pthread_cond_init( &group->finished, NULL ), "pthread_cond_init"
+  );
+  group->done = false;
+  group->xps = NULL;
+  group->n_xps = group->xps_cap = 0;
+  return group;
+}
+
+void cx_task_group_run( cx_task_group_t *group, cx_task_fn_t fn, void *arg ) {
+  assert( group != NULL );
+  assert( fn != NULL );
+  cx_impl_task_t *const task = malloc( sizeof *task );
+  if ( task == NULL ) {
+    perror( "malloc()" );
+    abort();
+  }
+  *task = (cx_impl_task_t){ .fn = fn, .arg = arg, .group = group };
+  atomic_fetch_add_explicit( &group->pending, 1, memory_order_relaxed );
+  cx_impl_task_pool_queue( group->pool, task );
+}
+
+void cx_task_group_wait( cx_task_group_t *group ) {
+  assert( group != NULL );
+  cx_task_pool_t *const pool = group->pool;
+  cx_impl_worker_t *const self = cx_impl_current_worker;
+
+  cx_impl_task_group_dec_pending( group );  // for the caller
+  while ( atomic_load_explicit( &group->pending, memory_order_acquire ) > 0 ) {
+    cx_impl_task_t *const task = cx_impl_task_pool_find(
+      pool, self != NULL && self->pool == pool ? self : NULL
+    );
+    if ( task != NULL ) {
+      cx_impl_task_run( task );
+      continue;
+    }
+    cx_impl_pthread_check(
+      pthread_mutex_lock( &group->mutex ), "pthread_mutex_lock"
+    );
+    while ( !group->done )
+      pthread_cond_wait( &group->finished, &group->mutex );
+    pthread_mutex_unlock( &group->mutex );
+  } // while
+
+  //
+  // Even though pending is 0, the thread that decremented it may still be
+  // signalling: wait for it to be done before the group can be reused or
+  // freed.
+  //
+  cx_impl_pthread_check(
+    pthread_mutex_lock( &group->mutex ), "pthread_mutex_lock"
+  );
+  while ( !group->done )
+    pthread_cond_wait( &group->finished, &group->mutex );
+  group->done = false;
+  pthread_mutex_unlock( &group->mutex );
+  atomic_store_explicit( &group->pending, 1, memory_order_relaxed );
+
+  if ( group->n_xps > 0 )
+    cx_rethrow_ptr( cx_exception_ptr_copy( group->xps[0] ) );
+}
+
+void cx_task_pool_free( cx_task_pool_t *pool ) {
+  if ( pool == NULL )
+    return;
+  cx_impl_pthread_check(
+    pthread_mutex_lock( &pool->mutex ), "pthread_mutex_lock"
+  );
+  pool->stopping = true;
+  pthread_cond_broadcast( &pool->work_available );
+  pthread_mutex_unlock( &pool->mutex );
+  for ( unsigned i = 0; i < pool->n_workers; ++i )
+    pthread_join( pool->workers[i].thread, NULL );
+  pthread_cond_destroy( &pool->work_available );
+  pthread_mutex_destroy( &pool->mutex );
+  free( pool->workers );
+  free( pool );
+}
+
+cx_task_pool_t* cx_task_pool_new( unsigned n_workers ) {
+  if ( n_workers == 0 ) {
+    long const n_cpus = sysconf( _SC_NPROCESSORS_ONLN );
+    n_workers = n_cpus > 0 ? (unsigned)n_cpus : 1;
+  }
+  cx_task_pool_t *const pool = malloc( sizeof *pool );
+  if ( pool == NULL ) {
+    perror( "malloc()" );
+    abort();
+  }
+  pool->workers = aligned_alloc(
+    CX_IMPL_CACHE_LINE_SIZE, n_workers * sizeof *pool->workers
+  );
+  if ( pool->workers == NULL ) {
+    perror( "aligned_alloc()" );
+    abort();
+  }
+  pool->n_workers = n_workers;
+  atomic_init( &pool->n_queued, 0 );
+  atomic_init( &pool->n_sleeping, 0 );
+  cx_impl_pthread_check(
+    pthread_mutex_init( &pool->mutex, NULL ), "pthread_mutex_init"
+  );
+  cx_impl_pthread_check(
+    pthread_cond_init( &pool->work_available, NULL ), "pthread_cond_init"
+  );
+  atomic_init( &pool->shared_head, NULL );
+  pool->shared_tail = NULL;
+  pool->stopping = false;
+
+  for ( unsigned i = 0; i < n_workers; ++i ) {
+    cx_impl_worker_t *const worker = &pool->workers[i];
+    atomic_init( &worker->deque.top, 0 );
+    atomic_init( &worker->deque.bottom, 0 );
+    worker->pool = pool;
+    worker->rand_state = i * 2654435761u + 1;
+  } // for
+  for ( unsigned i = 0; i < n_workers; ++i ) {
+    cx_impl_pthread_check(
+      pthread_create( &pool->workers[i].thread, NULL, &cx_impl_worker_main,
+                      &pool->workers[i] ),
+      "pthread_create"
+    );
+  } // for
+  return pool;
+}
+
+/** @} */
+
+///////////////////////////////////////////////////////////////////////////////
+/* vim:set et sw=2 ts=2: */
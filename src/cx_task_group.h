@@ -0,0 +1,204 @@
+/*
+**      C Exception -- Exception Library for C
+**      src/cx_task_group.h
+**
+**      Copyright (C) 2023-2024  Paul J. Lucas
+**
+**      This program is free software: you can redistribute it and/or modify
+**      it under the terms of the GNU General Public License as published by
+**      the Free Software Foundation, either version 3 of the License, or
+**      (at your option) any later version.
+**
+**      This program is distributed in the hope that it will be useful,
+**      but WITHOUT ANY WARRANTY; without even the implied warranty of
+**      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**      GNU General Public License for more details.
+**
+**      You should have received a copy of the GNU General Public License
+**      along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CX_TASK_GROUP_H
+#define CX_TASK_GROUP_H
+
+/**
+ * @file
+ * Declares types and functions to run groups of tasks on a pool of worker
+ * threads where an exception thrown by any task cancels the rest and is
+ * rethrown by the thread waiting for the group.
+ */
+
+// local
+#include "c_exception.h"
+
+// standard
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @defgroup cx-task-group-group Task Groups
+ * Types and functions to run groups of tasks on a pool of worker threads.
+ *
+ * @remarks
+ * @parblock
+ * Each worker thread has its own double-ended queue of tasks: a worker pushes
+ * and pops tasks it creates at one end; idle workers steal tasks from the
+ * other end of other workers' queues.  Tasks created by non-worker threads are
+ * queued on a shared queue.
+ *
+ * Each task runs within its own #cx_try block.  The first exception thrown by
+ * any task of a group that isn't caught by the task cancels the group: the
+ * group's tasks that have yet to start are skipped.
+ * @endparblock
+ *
+ * For example:
+ *  ```c
+ *  cx_task_pool_t *const pool = cx_task_pool_new( 0 );
+ *  cx_task_group_t *const group = cx_task_group_new( pool );
+ *  for ( size_t i = 0; i < n_files; ++i )
+ *    cx_task_group_run( group, &parse_file, files[i] );
+ *  cx_try {
+ *    cx_task_group_wait( group );      // rethrows first exception, if any
+ *  }
+ *  cx_catch() {
+ *    // ...
+ *  }
+ *  cx_task_group_free( group );
+ *  cx_task_pool_free( pool );
+ *  ```
+ *
+ * @{
+ */
+
+/**
+ * A pool of worker threads that run tasks.
+ *
+ * @sa cx_task_pool_new()
+ */
+typedef struct cx_task_pool cx_task_pool_t;
+
+/**
+ * A group of tasks that can be waited for.
+ *
+ * @sa cx_task_group_new()
+ */
+typedef struct cx_task_group cx_task_group_t;
+
+/**
+ * The signature for a task function.
+ *
+ * @param arg The argument passed to cx_task_group_run().
+ */
+typedef void (*cx_task_fn_t)( void *arg );
+
+/**
+ * Checks whether \a group has been cancelled because one of its tasks threw
+ * an exception.
+ *
+ * @remarks Long-running tasks may call this periodically to stop early.
+ *
+ * @param group The \ref cx_task_group to check.
+ * @return Returns `true` only if \a group has been cancelled.
+ */
+bool cx_task_group_cancelled( cx_task_group_t const *group );
+
+/**
+ * Gets an exception thrown by a task of \a group.
+ *
+ * @param group The \ref cx_task_group to get the exception of.
+ * @param i The index of the exception, where 0 is the first.
+ * @return Returns said exception that is valid until cx_task_group_free() is
+ * called.
+ *
+ * @sa cx_task_group_exception_count()
+ */
+cx_exception_ptr_t* cx_task_group_exception( cx_task_group_t const *group,
+                                             size_t i );
+
+/**
+ * Gets the number of exceptions thrown by tasks of \a group.
+ *
+ * @remarks More than one task can throw an exception if the tasks were
+ * already running when the group was cancelled.
+ *
+ * @param group The \ref cx_task_group to get the number of exceptions of.
+ * @return Returns said number.
+ *
+ * @sa cx_task_group_exception()
+ */
+size_t cx_task_group_exception_count( cx_task_group_t const *group );
+
+/**
+ * Frees \a group.
+ *
+ * @param group The \ref cx_task_group to free.  If NULL, does nothing.
+ *
+ * @warning All tasks of \a group must have been waited for.
+ */
+void cx_task_group_free( cx_task_group_t *group );
+
+/**
+ * Creates a new \ref cx_task_group.
+ *
+ * @param pool The \ref cx_task_pool to run tasks on.
+ * @return Returns said group.
+ *
+ * @sa cx_task_group_free()
+ */
+cx_task_group_t* cx_task_group_new( cx_task_pool_t *pool );
+
+/**
+ * Runs \a fn with \a arg as a task of \a group on a worker thread.
+ *
+ * @param group The \ref cx_task_group to add the task to.
+ * @param fn The task function.
+ * @param arg The argument to pass to \a fn.
+ *
+ * @note It may be called from within a task of \a group.
+ */
+void cx_task_group_run( cx_task_group_t *group, cx_task_fn_t fn, void *arg );
+
+/**
+ * Waits for all tasks of \a group to finish, helping to run tasks while
+ * waiting.  If any task threw an exception, rethrows the first.
+ *
+ * @param group The \ref cx_task_group to wait for.
+ *
+ * @sa cx_task_group_exception()
+ */
+void cx_task_group_wait( cx_task_group_t *group );
+
+/**
+ * Frees \a pool, waiting for all its worker threads to finish.
+ *
+ * @param pool The \ref cx_task_pool to free.  If NULL, does nothing.
+ */
+void cx_task_pool_free( cx_task_pool_t *pool );
+
+/**
+ * Creates a new \ref cx_task_pool.
+ *
+ * @param n_workers The number of worker threads or 0 for the number of
+ * online CPUs.
+ * @return Returns said pool.
+ *
+ * @sa cx_task_pool_free()
+ */
+cx_task_pool_t* cx_task_pool_new( unsigned n_workers );
+
+/** @} */
+
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef __cplusplus
+} // extern "C"
+#endif /* __cplusplus */
+
+#endif /* CX_TASK_GROUP_H */
+/* vim:set et sw=2 ts=2: */
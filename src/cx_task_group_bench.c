@@ -0,0 +1,143 @@
+/*
+**      C Exception -- Exception Library for C
+**      src/cx_task_group_bench.c
+**
+**      Copyright (C) 2023-2024  Paul J. Lucas
+**
+**      This program is free software: you can redistribute it and/or modify
+**      it under the terms of the GNU General Public License as published by
+**      the Free Software Foundation, either version 3 of the License, or
+**      (at your option) any later version.
+**
+**      This program is distributed in the hope that it will be useful,
+**      but WITHOUT ANY WARRANTY; without even the implied warranty of
+**      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**      GNU General Public License for more details.
+**
+**      You should have received a copy of the GNU General Public License
+**      along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * Scaling benchmarks for task groups.  Run via `make bench`.
+ */
+
+// local
+#include "config.h"                     /* must go first */
+#include "c_exception.h"
+#include "cx_task_group.h"
+
+// standard
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sysexits.h>
+#include <time.h>
+#include <unistd.h>
+
+///////////////////////////////////////////////////////////////////////////////
+
+#define BENCH_N_TASKS     100000UL
+#define BENCH_TASK_WORK   2000UL        /* loop iterations per task */
+#define BENCH_XID         0x0101
+
+/**
+ * Task argument.
+ */
+struct bench_task {
+  unsigned long sum;                    ///< Result.
+  bool          throws;                 ///< Throw #BENCH_XID when done?
+};
+typedef struct bench_task bench_task_t;
+
+// local variables
+static bench_task_t bench_tasks[ BENCH_N_TASKS ];
+
+////////// local functions ////////////////////////////////////////////////////
+
+/**
+ * Does a fixed amount of work, then throws if requested.
+ *
+ * @param arg A pointer to the \ref bench_task.
+ */
+static void bench_task_fn( void *arg ) {
+  bench_task_t *const task = arg;
+  unsigned long sum = 0;
+  for ( unsigned long i = 0; i < BENCH_TASK_WORK; ++i ) {
+    sum += i;
+    __asm__ ( "" : "+r" (sum) );        // prevent loop closed-form
+  } // for
+  task->sum = sum;
+  if ( task->throws )
+    cx_throw( BENCH_XID );
+}
+
+/**
+ * Gets the next number of workers to benchmark: doubles \a n up to \a max.
+ *
+ * @param n The current number of workers.
+ * @param max The maximum number of workers.
+ * @return Returns said number or 0 if \a n is \a max.
+ */
+static unsigned bench_next_n_workers( unsigned n, unsigned max ) {
+  return n == max ? 0 : n * 2 > max ? max : n * 2;
+}
+
+/**
+ * Runs #BENCH_N_TASKS tasks on a pool of \a n_workers workers and prints the
+ * elapsed time.
+ *
+ * @param n_workers The number of worker threads.
+ * @param throw_at The index of the task that throws or #BENCH_N_TASKS for
+ * none.
+ */
+static void bench_run( unsigned n_workers, unsigned long throw_at ) {
+  for ( unsigned long i = 0; i < BENCH_N_TASKS; ++i )
+    bench_tasks[i] = (bench_task_t){ .throws = i == throw_at };
+
+  cx_task_pool_t *const pool = cx_task_pool_new( n_workers );
+  cx_task_group_t *const group = cx_task_group_new( pool );
+  struct timespec start, end;
+
+  clock_gettime( CLOCK_MONOTONIC, &start );
+  for ( unsigned long i = 0; i < BENCH_N_TASKS; ++i )
+    cx_task_group_run( group, &bench_task_fn, &bench_tasks[i] );
+  cx_try {
+    cx_task_group_wait( group );
+  }
+  cx_catch( BENCH_XID ) {
+    // expected for failure path
+  }
+  clock_gettime( CLOCK_MONOTONIC, &end );
+
+  unsigned long n_ran = 0;
+  for ( unsigned long i = 0; i < BENCH_N_TASKS; ++i )
+    n_ran += bench_tasks[i].sum != 0;
+
+  double const ms = (double)(end.tv_sec - start.tv_sec) * 1e3
+                  + (double)(end.tv_nsec - start.tv_nsec) / 1e6;
+  printf( "  %3u worker(s) %10.2f ms %8lu tasks ran\n", n_workers, ms, n_ran );
+
+  cx_task_group_free( group );
+  cx_task_pool_free( pool );
+}
+
+int main( void ) {
+  long const n_cpus = sysconf( _SC_NPROCESSORS_ONLN );
+  unsigned const max_workers = n_cpus > 0 ? (unsigned)n_cpus : 1;
+
+  printf( "task group success path (%lu tasks):\n", BENCH_N_TASKS );
+  for ( unsigned n = 1; n > 0; n = bench_next_n_workers( n, max_workers ) )
+    bench_run( n, BENCH_N_TASKS );
+
+  printf( "task group failure path (task %lu of %lu throws):\n",
+          BENCH_N_TASKS / 10, BENCH_N_TASKS );
+  for ( unsigned n = 1; n > 0; n = bench_next_n_workers( n, max_workers ) )
+    bench_run( n, BENCH_N_TASKS / 10 );
+
+  exit( EX_OK );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/* vim:set et sw=2 ts=2: */
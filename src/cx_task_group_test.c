@@ -0,0 +1,226 @@
+/*
+**      C Exception -- Exception Library for C
+**      src/cx_task_group_test.c
+**
+**      Copyright (C) 2023-2024  Paul J. Lucas
+**
+**      This program is free software: you can redistribute it and/or modify
+**      it under the terms of the GNU General Public License as published by
+**      the Free Software Foundation, either version 3 of the License, or
+**      (at your option) any later version.
+**
+**      This program is distributed in the hope that it will be useful,
+**      but WITHOUT ANY WARRANTY; without even the implied warranty of
+**      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**      GNU General Public License for more details.
+**
+**      You should have received a copy of the GNU General Public License
+**      along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * Tests task groups.
+ */
+
+// local
+#include "config.h"                     /* must go first */
+#include "c_exception.h"
+#include "cx_task_group.h"
+#include "unit_test.h"
+
+// standard
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sysexits.h>
+
+///////////////////////////////////////////////////////////////////////////////
+
+#define TEST_N_TASKS  1000
+#define TEST_XID_01   0x0101
+
+/**
+ * A range of numbers to sum by test_sum_task().
+ */
+struct test_range {
+  cx_task_pool_t   *pool;               ///< Pool to run subtasks on.
+  unsigned long     lo;                 ///< Lowest number, inclusive.
+  unsigned long     hi;                 ///< Highest number, exclusive.
+};
+typedef struct test_range test_range_t;
+
+// extern variables
+char const         *me;
+
+// local variables
+static atomic_uint  test_n_ran;
+static atomic_uint  test_n_started;
+static atomic_ulong test_sum;
+static unsigned     test_failures;
+
+////////// local functions ////////////////////////////////////////////////////
+
+/**
+ * Counts that it ran.
+ *
+ * @param arg Not used.
+ */
+static void test_count_task( void *arg ) {
+  (void)arg;
+  atomic_fetch_add( &test_n_ran, 1 );
+}
+
+/**
+ * Sums a range of numbers by splitting it in half and summing each half as a
+ * subtask of a nested group.
+ *
+ * @param arg A pointer to the \ref test_range to sum.
+ */
+static void test_sum_task( void *arg ) {
+  test_range_t const *const r = arg;
+  if ( r->hi - r->lo <= 16 ) {
+    for ( unsigned long i = r->lo; i < r->hi; ++i )
+      atomic_fetch_add( &test_sum, i );
+    return;
+  }
+  unsigned long const mid = r->lo + (r->hi - r->lo) / 2;
+  test_range_t halves[] = {
+    { r->pool, r->lo, mid },
+    { r->pool, mid, r->hi }
+  };
+  cx_task_group_t *const group = cx_task_group_new( r->pool );
+  cx_task_group_run( group, &test_sum_task, &halves[0] );
+  cx_task_group_run( group, &test_sum_task, &halves[1] );
+  cx_task_group_wait( group );
+  cx_task_group_free( group );
+}
+
+/**
+ * Throws #TEST_XID_01.
+ *
+ * @param arg Not used.
+ */
+static void test_throw_task( void *arg ) {
+  (void)arg;
+  cx_throw( TEST_XID_01 );
+}
+
+/**
+ * Waits until 2 tasks have started, then throws the exception ID pointed to
+ * by \a arg.
+ *
+ * @param arg A pointer to the exception ID to throw.
+ */
+static void test_throw_together_task( void *arg ) {
+  atomic_fetch_add( &test_n_started, 1 );
+  while ( atomic_load( &test_n_started ) < 2 )
+    ;
+  cx_throw( *(int const*)arg );
+}
+
+static bool test_task_group_aggregate( cx_task_pool_t *pool ) {
+  TEST_FN_BEGIN();
+  static int const xids[] = { TEST_XID_01, TEST_XID_01 + 1 };
+  atomic_store( &test_n_started, 0 );
+  cx_task_group_t *const group = cx_task_group_new( pool );
+  cx_task_group_run( group, &test_throw_together_task, (void*)&xids[0] );
+  cx_task_group_run( group, &test_throw_together_task, (void*)&xids[1] );
+  unsigned volatile n_catch = 0;
+  cx_try {
+    cx_task_group_wait( group );
+  }
+  cx_catch_range( TEST_XID_01, TEST_XID_01 + 1 ) {
+    ++n_catch;
+  }
+  TEST( n_catch == 1 );
+  if ( TEST( cx_task_group_exception_count( group ) == 2 ) ) {
+    int const xid0 =
+      cx_exception_ptr_exception( cx_task_group_exception( group, 0 ) )->thrown_xid;
+    int const xid1 =
+      cx_exception_ptr_exception( cx_task_group_exception( group, 1 ) )->thrown_xid;
+    TEST( xid0 + xid1 == TEST_XID_01 * 2 + 1 );
+  }
+  cx_task_group_free( group );
+  TEST_FN_END();
+}
+
+static bool test_task_group_cancel( cx_task_pool_t *pool ) {
+  TEST_FN_BEGIN();
+  cx_task_group_t *const group = cx_task_group_new( pool );
+  cx_task_group_run( group, &test_throw_task, NULL );
+  unsigned volatile n_catch = 0;
+  cx_try {
+    cx_task_group_wait( group );
+  }
+  cx_catch( TEST_XID_01 ) {
+    ++n_catch;
+  }
+  TEST( n_catch == 1 );
+  TEST( cx_task_group_cancelled( group ) );
+  TEST( cx_task_group_exception_count( group ) == 1 );
+
+  // Tasks queued to a cancelled group must be skipped.
+  atomic_store( &test_n_ran, 0 );
+  for ( unsigned i = 0; i < TEST_N_TASKS; ++i )
+    cx_task_group_run( group, &test_count_task, NULL );
+  n_catch = 0;
+  cx_try {
+    cx_task_group_wait( group );
+  }
+  cx_catch( TEST_XID_01 ) {
+    ++n_catch;
+  }
+  TEST( n_catch == 1 );
+  TEST( atomic_load( &test_n_ran ) == 0 );
+  TEST( cx_current_exception() == NULL );
+  cx_task_group_free( group );
+  TEST_FN_END();
+}
+
+static bool test_task_group_nested( cx_task_pool_t *pool ) {
+  TEST_FN_BEGIN();
+  unsigned long const n = 100000;
+  atomic_store( &test_sum, 0 );
+  test_range_t range = { pool, 0, n };
+  cx_task_group_t *const group = cx_task_group_new( pool );
+  cx_task_group_run( group, &test_sum_task, &range );
+  cx_task_group_wait( group );
+  TEST( atomic_load( &test_sum ) == n * (n - 1) / 2 );
+  cx_task_group_free( group );
+  TEST_FN_END();
+}
+
+static bool test_task_group_success( cx_task_pool_t *pool ) {
+  TEST_FN_BEGIN();
+  atomic_store( &test_n_ran, 0 );
+  cx_task_group_t *const group = cx_task_group_new( pool );
+  for ( unsigned i = 0; i < TEST_N_TASKS; ++i )
+    cx_task_group_run( group, &test_count_task, NULL );
+  cx_task_group_wait( group );
+  TEST( atomic_load( &test_n_ran ) == TEST_N_TASKS );
+  TEST( !cx_task_group_cancelled( group ) );
+  TEST( cx_task_group_exception_count( group ) == 0 );
+  cx_task_group_free( group );
+  TEST_FN_END();
+}
+
+int main( int argc, char const *argv[] ) {
+  (void)argc;
+  me = argv[0];
+
+  for ( unsigned n_workers = 1; n_workers <= 4; n_workers *= 2 ) {
+    cx_task_pool_t *const pool = cx_task_pool_new( n_workers );
+    test_task_group_success( pool );
+    test_task_group_nested( pool );
+    test_task_group_cancel( pool );
+    test_task_group_aggregate( pool );
+    cx_task_pool_free( pool );
+  } // for
+
+  printf( "%u failures\n", test_failures );
+  exit( test_failures > 0 ? EX_SOFTWARE : EX_OK );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/* vim:set et sw=2 ts=2: */
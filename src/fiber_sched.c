@@ -0,0 +1,174 @@
+/*
+**      C Exception -- Exception Library for C
+**      src/fiber_sched.c
+**
+**      Copyright (C) 2023-2024  Paul J. Lucas
+**
+**      This program is free software: you can redistribute it and/or modify
+**      it under the terms of the GNU General Public License as published by
+**      the Free Software Foundation, either version 3 of the License, or
+**      (at your option) any later version.
+**
+**      This program is distributed in the hope that it will be useful,
+**      but WITHOUT ANY WARRANTY; without even the implied warranty of
+**      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**      GNU General Public License for more details.
+**
+**      You should have received a copy of the GNU General Public License
+**      along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @file
+ * Defines functions for a minimal round-robin fiber scheduler based on
+ * `ucontext`.
+ */
+
+// local
+#include "config.h"                     /* must go first */
+#include "c_exception.h"
+#include "fiber_sched.h"
+
+// standard
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <ucontext.h>
+
+#if defined(__SANITIZE_ADDRESS__)
+# define FIBER_ASAN               1
+#elif defined(__has_feature)
+# if __has_feature(address_sanitizer)
+#   define FIBER_ASAN             1
+# endif
+#endif
+
+#ifdef FIBER_ASAN
+#include <sanitizer/common_interface_defs.h>
+//
+// AddressSanitizer must be told about stack switches; otherwise, it ignores
+// the longjmp()s done by exceptions thrown within fibers and leaves the stack
+// frames jumped over poisoned.
+//
+# define FIBER_ASAN_START(FAKE,BOTTOM,SIZE) \
+    __sanitizer_start_switch_fiber( (FAKE), (BOTTOM), (SIZE) )
+# define FIBER_ASAN_FINISH(FAKE,BOTTOM,SIZE) \
+    __sanitizer_finish_switch_fiber( (FAKE), (BOTTOM), (SIZE) )
+#else
+# define FIBER_ASAN_START(FAKE,BOTTOM,SIZE)   ((void)0)
+# define FIBER_ASAN_FINISH(FAKE,BOTTOM,SIZE)  ((void)0)
+#endif /* FIBER_ASAN */
+
+///////////////////////////////////////////////////////////////////////////////
+
+#define FIBER_MAX         64            /* maximum number of fibers */
+#define FIBER_STACK_SIZE  (1024 * 1024)
+
+/**
+ * A fiber.
+ */
+struct fiber {
+  ucontext_t        ctx;                ///< Execution context.
+  cx_fiber_state_t  cx_state;           ///< C Exception state.
+  fiber_fn_t        fn;                 ///< Fiber function.
+  void             *arg;                ///< Argument to \ref fn.
+  void             *stack;              ///< Stack.
+  bool              done;               ///< Has \ref fn returned?
+};
+typedef struct fiber fiber_t;
+
+// local variables
+static int              fiber_current = -1; ///< Index of current fiber.
+static unsigned         fiber_n;        ///< Number of fibers.
+static fiber_t          fibers[ FIBER_MAX ];
+static ucontext_t       fiber_sched_ctx;
+static cx_fiber_state_t fiber_sched_cx_state;
+#ifdef FIBER_ASAN
+static void const      *fiber_sched_stack_bottom;
+static size_t           fiber_sched_stack_size;
+#endif /* FIBER_ASAN */
+
+////////// local functions ////////////////////////////////////////////////////
+
+/**
+ * The entry point of every fiber.
+ */
+static void fiber_main( void ) {
+  FIBER_ASAN_FINISH( NULL, &fiber_sched_stack_bottom, &fiber_sched_stack_size );
+  fiber_t *const f = &fibers[ fiber_current ];
+  (*f->fn)( f->arg );
+  f->done = true;
+  cx_state_swap( &f->cx_state, &fiber_sched_cx_state );
+  FIBER_ASAN_START( NULL, fiber_sched_stack_bottom, fiber_sched_stack_size );
+  // Returning resumes fiber_sched_ctx via uc_link.
+}
+
+////////// extern functions ///////////////////////////////////////////////////
+
+void fiber_run( void ) {
+  assert( fiber_current == -1 );
+  for ( bool all_done = false; !all_done; ) {
+    all_done = true;
+    for ( unsigned i = 0; i < fiber_n; ++i ) {
+      fiber_t *const f = &fibers[i];
+      if ( f->done )
+        continue;
+      all_done = false;
+      fiber_current = (int)i;
+      cx_state_swap( &fiber_sched_cx_state, &f->cx_state );
+#ifdef FIBER_ASAN
+      void *fake_stack;
+#endif /* FIBER_ASAN */
+      FIBER_ASAN_START( &fake_stack, f->stack, FIBER_STACK_SIZE );
+      swapcontext( &fiber_sched_ctx, &f->ctx );
+      FIBER_ASAN_FINISH( fake_stack, NULL, NULL );
+      fiber_current = -1;
+    } // for
+  } // for
+
+  for ( unsigned i = 0; i < fiber_n; ++i )
+    free( fibers[i].stack );
+  fiber_n = 0;
+}
+
+void fiber_spawn( fiber_fn_t fn, void *arg ) {
+  assert( fn != NULL );
+  if ( fiber_n == FIBER_MAX ) {
+    fprintf( stderr, "too many fibers\n" );
+    abort();
+  }
+  fiber_t *const f = &fibers[ fiber_n++ ];
+  *f = (fiber_t){
+    .cx_state = CX_FIBER_STATE_INIT,
+    .fn = fn,
+    .arg = arg,
+    .stack = malloc( FIBER_STACK_SIZE )
+  };
+  if ( f->stack == NULL ) {
+    perror( "malloc()" );
+    abort();
+  }
+  getcontext( &f->ctx );
+  f->ctx.uc_stack.ss_sp = f->stack;
+  f->ctx.uc_stack.ss_size = FIBER_STACK_SIZE;
+  f->ctx.uc_link = &fiber_sched_ctx;
+  makecontext( &f->ctx, &fiber_main, 0 );
+}
+
+void fiber_yield( void ) {
+  if ( fiber_current == -1 )
+    return;
+  fiber_t *const f = &fibers[ fiber_current ];
+  cx_state_swap( &f->cx_state, &fiber_sched_cx_state );
+#ifdef FIBER_ASAN
+  void *fake_stack;
+#endif /* FIBER_ASAN */
+  FIBER_ASAN_START( &fake_stack, fiber_sched_stack_bottom,
+                    fiber_sched_stack_size );
+  swapcontext( &f->ctx, &fiber_sched_ctx );
+  FIBER_ASAN_FINISH( fake_stack, NULL, NULL );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/* vim:set et sw=2 ts=2: */
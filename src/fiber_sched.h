@@ -0,0 +1,64 @@
+/*
+**      C Exception -- Exception Library for C
+**      src/fiber_sched.h
+**
+**      Copyright (C) 2023-2024  Paul J. Lucas
+**
+**      This program is free software: you can redistribute it and/or modify
+**      it under the terms of the GNU General Public License as published by
+**      the Free Software Foundation, either version 3 of the License, or
+**      (at your option) any later version.
+**
+**      This program is distributed in the hope that it will be useful,
+**      but WITHOUT ANY WARRANTY; without even the implied warranty of
+**      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**      GNU General Public License for more details.
+**
+**      You should have received a copy of the GNU General Public License
+**      along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef c_exception_fiber_sched_H
+#define c_exception_fiber_sched_H
+
+/**
+ * @file
+ * Declares functions for a minimal round-robin fiber scheduler based on
+ * `ucontext` that serves as a reference for how a fiber scheduler uses
+ * cx_state_swap().
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * The signature for a fiber function.
+ *
+ * @param arg The argument passed to fiber_spawn().
+ */
+typedef void (*fiber_fn_t)( void *arg );
+
+/**
+ * Runs all spawned fibers on the current thread until they all return.
+ *
+ * @sa fiber_spawn()
+ */
+void fiber_run( void );
+
+/**
+ * Spawns a new fiber that will call \a fn when fiber_run() is called.
+ *
+ * @param fn The fiber function.
+ * @param arg The argument to pass to \a fn.
+ */
+void fiber_spawn( fiber_fn_t fn, void *arg );
+
+/**
+ * Switches to the next fiber, if any.  If not called from within a fiber,
+ * does nothing.
+ */
+void fiber_yield( void );
+
+///////////////////////////////////////////////////////////////////////////////
+
+#endif /* c_exception_fiber_sched_H */
+/* vim:set et sw=2 ts=2: */
@@ -42,7 +42,15 @@
  * @param EXPR The expression to evaluate.
  * @return Returns `true` only if \a EXPR is non-zero; `false` only if zero.
  */
-#define TEST(EXPR)                ( !!(EXPR) || FAILED( #EXPR ) )
+#define TEST(EXPR)                ( TEST_YIELD(), !!(EXPR) || FAILED( #EXPR ) )
+
+#ifndef TEST_YIELD
+/**
+ * Called by #TEST() before evaluating its expression.  A test program may
+ * define it before including this file, e.g., to switch fibers.
+ */
+#define TEST_YIELD()              ((void)0)
+#endif /* TEST_YIELD */
 
 /**
  * Begins a test function.